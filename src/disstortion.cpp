@@ -1,5 +1,6 @@
 #include "disstortion.h"
 
+#include "dsp/DenormalGuard.h"
 #include "utils/Logger.h"
 #include "presets/PresetManager.h"
 
@@ -7,11 +8,84 @@
 #include <clap/helpers/plugin.hh>
 #include <clap/helpers/plugin.hxx>
 #include <nlohmann/json.hpp>
+#include <string_view>
 
 namespace stfefane {
 
 static const char* kClapFeatures[] = {CLAP_PLUGIN_FEATURE_AUDIO_EFFECT, nullptr};
 
+// Access the channels of a clap audio buffer in the requested precision
+template <typename SampleType>
+static SampleType** channelsData(const clap_audio_buffer* buffer) {
+    if constexpr (std::is_same_v<SampleType, double>) {
+        return buffer->data64;
+    } else {
+        return buffer->data32;
+    }
+}
+
+// Bus layouts offered through the audio-ports-config extension, the processing adapts to any channel count.
+struct PortsLayout {
+    const char* name;
+    const char* port_type;
+    uint32_t channel_count;
+    std::array<uint8_t, Disstortion::kMaxChannels> channel_map;
+};
+
+static constexpr std::array kPortsLayouts = {
+    PortsLayout{"Mono", CLAP_PORT_MONO, 1, {CLAP_SURROUND_FC}},
+    PortsLayout{"Stereo", CLAP_PORT_STEREO, 2, {CLAP_SURROUND_FL, CLAP_SURROUND_FR}},
+    PortsLayout{"5.1", CLAP_PORT_SURROUND, 6,
+                {CLAP_SURROUND_FL, CLAP_SURROUND_FR, CLAP_SURROUND_FC, CLAP_SURROUND_LFE, CLAP_SURROUND_BL,
+                 CLAP_SURROUND_BR}},
+    PortsLayout{"7.1", CLAP_PORT_SURROUND, 8,
+                {CLAP_SURROUND_FL, CLAP_SURROUND_FR, CLAP_SURROUND_FC, CLAP_SURROUND_LFE, CLAP_SURROUND_BL,
+                 CLAP_SURROUND_BR, CLAP_SURROUND_SL, CLAP_SURROUND_SR}},
+    PortsLayout{"7.1.2", CLAP_PORT_SURROUND, 10,
+                {CLAP_SURROUND_FL, CLAP_SURROUND_FR, CLAP_SURROUND_FC, CLAP_SURROUND_LFE, CLAP_SURROUND_BL,
+                 CLAP_SURROUND_BR, CLAP_SURROUND_SL, CLAP_SURROUND_SR, CLAP_SURROUND_TFL, CLAP_SURROUND_TFR}},
+    PortsLayout{"7.1.4", CLAP_PORT_SURROUND, 12,
+                {CLAP_SURROUND_FL, CLAP_SURROUND_FR, CLAP_SURROUND_FC, CLAP_SURROUND_LFE, CLAP_SURROUND_BL,
+                 CLAP_SURROUND_BR, CLAP_SURROUND_SL, CLAP_SURROUND_SR, CLAP_SURROUND_TFL, CLAP_SURROUND_TFR,
+                 CLAP_SURROUND_TBL, CLAP_SURROUND_TBR}},
+};
+
+static bool isSurround(const PortsLayout& layout) {
+    return std::string_view(layout.port_type) == CLAP_PORT_SURROUND;
+}
+
+static uint64_t channelMask(const PortsLayout& layout) {
+    uint64_t mask = 0;
+    for (uint32_t ch = 0; ch < layout.channel_count; ++ch) {
+        mask |= uint64_t(1) << layout.channel_map[ch];
+    }
+    return mask;
+}
+
+// Channels of the input port that reach the processing
+static uint32_t inputChannelCount(const clap_process* process) {
+    return process->audio_inputs_count > 0 ? std::min(process->audio_inputs[0].channel_count, Disstortion::kMaxChannels)
+                                           : 0;
+}
+
+// True when every input channel is zero for the whole block, relying on the host constant_mask when set.
+template <typename SampleType>
+static bool isInputSilent(const clap_process* process, const SampleType* const* data) {
+    if (data == nullptr) {
+        return true;
+    }
+
+    const auto& in = process->audio_inputs[0];
+    for (uint32_t ch = 0; ch < inputChannelCount(process); ++ch) {
+        const bool is_constant = ch < 64 && (in.constant_mask & (uint64_t(1) << ch)) != 0;
+        const uint32_t frames = is_constant ? std::min(process->frames_count, 1u) : process->frames_count;
+        if (!std::all_of(data[ch], data[ch] + frames, [](SampleType s) { return s == SampleType(0); })) {
+            return false;
+        }
+    }
+    return true;
+}
+
 clap_plugin_descriptor Disstortion::descriptor = {CLAP_VERSION,
                                                   "dev.stephanealbanese.disstortion" PLUGIN_ID_SUFFIX,
                                                   "Disstortion" PLUGIN_ID_SUFFIX,
@@ -25,29 +99,85 @@ clap_plugin_descriptor Disstortion::descriptor = {CLAP_VERSION,
 
 Disstortion::Disstortion(const clap_host* host)
 : ClapPluginBase(&descriptor, host)
-, mPresetManager(std::make_unique<presets::PresetManager>(*this)) {
+, mPresetManager(std::make_unique<presets::PresetManager>(*this))
+, mOversamplingAttachment(getParameter(params::eOversampling), [this](params::Parameter*, double) { requestAntialiasingRestart(); })
+, mOversamplingMethodAttachment(getParameter(params::eOversamplingMethod),
+                                [this](params::Parameter*, double) { requestAntialiasingRestart(); })
+, mAdaaOrderAttachment(getParameter(params::eAdaaOrder), [this](params::Parameter*, double) { requestAntialiasingRestart(); }) {
     LOG_INFO("dsp", "[Disstortion::constructor]");
-
-    // register the parameter listeners on the engine and init the values.
-    std::ranges::for_each(mDistoProcessors, [&](auto& proc) { proc.initParameterAttachments(*this); });
-    for (const auto& param: mParameters.getParams()) {
-        param->notifyAllListeners();
-    }
 }
 
 presets::PresetManager& Disstortion::getPresetManager() const {
     return *mPresetManager;
 }
 
-bool Disstortion::activate(double sampleRate, uint32_t, uint32_t) noexcept {
+void Disstortion::requestAntialiasingRestart() {
+    // The oversampling and ADAA are set up on activation, the plugin has to restart for new settings to apply.
+    if (isActive()) {
+        _host.requestRestart();
+    }
+}
+
+bool Disstortion::activate(double sampleRate, uint32_t, uint32_t maxFrames) noexcept {
     LOG_INFO("dsp", "[Disstortion::activate]");
-    std::ranges::for_each(mDistoProcessors, [&](auto& proc) { proc.setSampleRate(sampleRate); });
+    // The oversampling factor is chosen by the user, offline renders can afford to double it with longer kernels.
+    const auto factor_index = static_cast<uint32_t>(getParameter(params::eOversampling)->getValue());
+    const auto method = static_cast<dsp::OversamplingMethod>(getParameter(params::eOversamplingMethod)->getValue());
+    dsp::OversamplingSetup oversampling{.factor = 1u << factor_index, .method = method};
+    if (mRenderMode == CLAP_RENDER_OFFLINE) {
+        oversampling.factor = std::min(oversampling.factor * 2, dsp::kMaxOversamplingFactor);
+        oversampling.high_quality = true;
+    }
+    mDistoProcessor32.setOversampling(oversampling);
+    mDistoProcessor64.setOversampling(oversampling);
+    const auto adaa_order = static_cast<dsp::AdaaOrder>(getParameter(params::eAdaaOrder)->getValue());
+    mDistoProcessor32.setAdaaOrder(adaa_order);
+    mDistoProcessor64.setAdaaOrder(adaa_order);
+    // The processing starts from the current values, without ramping from the previous activation.
+    const auto& parameters = mParameterSnapshot.update();
+    mDistoProcessor32.setParameters(parameters);
+    mDistoProcessor64.setParameters(parameters);
+    mDistoProcessor32.setSampleRate(sampleRate);
+    mDistoProcessor64.setSampleRate(sampleRate);
+    mDistoProcessor32.setMaxBlockSize(maxFrames);
+    mDistoProcessor64.setMaxBlockSize(maxFrames);
+    mInputConversion32.max_frames = maxFrames;
+    mInputConversion64.max_frames = maxFrames;
+    mInputConversion32.buffer.assign(std::size_t{kMaxChannels} * maxFrames, 0.f);
+    mInputConversion64.buffer.assign(std::size_t{kMaxChannels} * maxFrames, 0.);
+    const auto nb_channels = kPortsLayouts[mPortsConfigIndex].channel_count;
+    mDistoProcessor32.setChannelCount(nb_channels);
+    mDistoProcessor64.setChannelCount(nb_channels);
+    mTailSamples = mDistoProcessor64.tailSamples();
+
+    // The oversampling setup defines the latency, the host can only be told about it while activating.
+    if (mDistoProcessor64.latencySamples() != mReportedLatency) {
+        mReportedLatency = mDistoProcessor64.latencySamples();
+        if (_host.canUseLatency()) {
+            _host.latencyChanged();
+        }
+    }
+    return true;
+}
+
+bool Disstortion::renderSetMode(clap_plugin_render_mode mode) noexcept {
+    LOG_INFO("dsp", "[Disstortion::renderSetMode] offline = {}", mode == CLAP_RENDER_OFFLINE);
+    if (mode == mRenderMode) {
+        return true;
+    }
+    mRenderMode = mode;
+    // Changing the oversampling while processing would glitch and change the latency,
+    // so it's applied by restarting the plugin.
+    if (isActive()) {
+        _host.requestRestart();
+    }
     return true;
 }
 
 void Disstortion::reset() noexcept {
     LOG_INFO("dsp", "[Disstortion::reset]");
-    std::ranges::for_each(mDistoProcessors, [&](auto& proc) { proc.reset(); });
+    mDistoProcessor32.reset();
+    mDistoProcessor64.reset();
 }
 
 clap_process_status Disstortion::process(const clap_process* process) noexcept {
@@ -56,63 +186,233 @@ clap_process_status Disstortion::process(const clap_process* process) noexcept {
         return CLAP_PROCESS_CONTINUE;
     }
 
+    // Denormals would only slow down the decaying filter states, let the FPU flush them for the whole block.
+    const dsp::DenormalGuard denormal_guard;
+
     handleEventsFromUIQueue(process->out_events);
-    processEvents(process->in_events);
 
-    const auto* in = process->audio_inputs_count > 0 ? process->audio_inputs : nullptr;
+    // The host picks the precision of each port. The output one decides which chain runs,
+    // an input in the other precision is converted to it.
+    const auto& out = process->audio_outputs[0];
+    if (out.data32 == nullptr && out.data64 == nullptr) {
+        return CLAP_PROCESS_ERROR;
+    }
+    const bool use_64bits = out.data64 != nullptr;
+
+    return use_64bits ? processWithEngine(process, mDistoProcessor64) : processWithEngine(process, mDistoProcessor32);
+}
+
+template <typename SampleType>
+clap_process_status Disstortion::processWithEngine(const clap_process* process, dsp::MultiDisto<SampleType>& processor) {
+    const auto* const* in_data = inputChannels<SampleType>(process);
+    // Nothing to compute when the input is silent and the chain has stopped ringing, the events still apply.
+    const bool input_silent = isInputSilent(process, in_data);
+    const bool skip_audio = input_silent && processor.isQuiet();
+
+    // Events are sorted by time, so the block is rendered in slices between them
+    // for each parameter change to land on its exact sample.
+    const auto* in_events = process->in_events;
+    const uint32_t event_count = in_events->size(in_events);
+    const uint32_t frames = process->frames_count;
+    uint32_t event_index = 0;
+    uint32_t frame = 0;
+    while (frame < frames) {
+        uint32_t next_frame = frames;
+        while (event_index < event_count) {
+            const auto* event = in_events->get(in_events, event_index);
+            if (event->time > frame) {
+                next_frame = std::min(event->time, frames);
+                break;
+            }
+            processEvent(event);
+            ++event_index;
+        }
+        // The values written since the last slice, by the events or from another thread, apply from here.
+        processor.setParameters(mParameterSnapshot.update());
+        if (!skip_audio) {
+            processAudio(process, in_data, frame, next_frame, processor);
+        }
+        frame = next_frame;
+    }
+
+    // Don't lose the events that would be timed after the end of the block.
+    for (; event_index < event_count; ++event_index) {
+        processEvent(in_events->get(in_events, event_index));
+    }
+
+    // The filter settings may have changed the ringing time.
+    if (processor.consumeTailChange()) {
+        const auto tail = processor.tailSamples();
+        if (tail != mTailSamples.exchange(tail) && _host.canUseTail()) {
+            _host.tailChanged();
+        }
+    }
+
     auto* out = process->audio_outputs;
+    if (skip_audio) {
+        auto** out_data = channelsData<SampleType>(out);
+        for (uint32_t ch = 0; ch < out->channel_count; ++ch) {
+            std::fill_n(out_data[ch], frames, SampleType(0));
+        }
+        out->constant_mask = ~uint64_t(0);
+        return CLAP_PROCESS_SLEEP;
+    }
 
-    const uint32_t in_channels = in ? in->channel_count : 0;
+    out->constant_mask = 0;
+    if (!input_silent) {
+        return CLAP_PROCESS_CONTINUE;
+    }
+    // Silent input: keep going while the tail rings, then clear the leftovers and let the host sleep.
+    if (processor.isQuiet()) {
+        processor.reset();
+        return CLAP_PROCESS_SLEEP;
+    }
+    return CLAP_PROCESS_TAIL;
+}
+
+template <typename SampleType>
+void Disstortion::processAudio(const clap_process* process, const SampleType* const* in_data, uint32_t start,
+                               uint32_t end, dsp::MultiDisto<SampleType>& processor) {
+    auto* out = process->audio_outputs;
+
+    const uint32_t in_channels = in_data ? inputChannelCount(process) : 0;
     const uint32_t out_channels = out->channel_count;
-    const uint32_t frames = process->frames_count;
+    const uint32_t frames = end - start;
+
+    auto** out_data = channelsData<SampleType>(out);
 
     // If no input, output silence
     if (in_channels == 0) {
         for (uint32_t ch = 0; ch < out_channels; ++ch) {
-            std::fill_n(out->data32[ch], frames, 0.0f);
+            std::fill_n(out_data[ch] + start, frames, SampleType(0));
         }
-        return CLAP_PROCESS_CONTINUE;
+        return;
     }
 
-    const uint32_t proc_channels = std::min({in_channels, out_channels, static_cast<uint32_t>(mDistoProcessors.size())});
+    const uint32_t proc_channels = std::min({in_channels, out_channels, kPortsLayouts[mPortsConfigIndex].channel_count});
 
-    // Process available channel pairs
+    // Process the available channels together
+    auto& job = groupsJob<SampleType>();
+    job.processor = &processor;
+    job.nb_channels = proc_channels;
+    job.frames = frames;
     for (uint32_t ch = 0; ch < proc_channels; ++ch) {
-        auto &proc = mDistoProcessors[ch];
-        float* outCh = out->data32[ch];
-        const float* inCh = in->data32[ch];
-        for (uint32_t f = 0; f < frames; ++f) {
-            outCh[f] = static_cast<float>(proc.process(static_cast<double>(inCh[f])));
+        job.in[ch] = in_data[ch] + start;
+        job.out[ch] = out_data[ch] + start;
+    }
+
+    const uint32_t nb_groups = processor.groupCount(proc_channels);
+    if (shouldUseThreadPool(nb_groups, frames)) {
+        processor.beginBlock(frames);
+        mGroupsJobIs64 = std::is_same_v<SampleType, double>;
+        if (!_host.threadPoolRequestExec(nb_groups)) {
+            // The pool is not available right now, run the tasks here.
+            for (uint32_t g = 0; g < nb_groups; ++g) {
+                job.run(g);
+            }
         }
+    } else {
+        processor.processBlock(job.in.data(), job.out.data(), proc_channels, frames);
     }
 
     // If mono-in and more outputs, duplicate left to others
     if (in_channels == 1 && out_channels > 1) {
-        const float* left = out->data32[0];
+        const SampleType* left = out_data[0] + start;
         for (uint32_t ch = 1; ch < out_channels; ++ch) {
-            std::copy_n(left, frames, out->data32[ch]);
+            std::copy_n(left, frames, out_data[ch] + start);
         }
     } else if (out_channels > proc_channels) {
         // Zero any remaining output channels to avoid garbage/noise
         for (uint32_t ch = proc_channels; ch < out_channels; ++ch) {
-            std::fill_n(out->data32[ch], frames, 0.0f);
+            std::fill_n(out_data[ch] + start, frames, SampleType(0));
         }
     }
+}
 
-    return CLAP_PROCESS_CONTINUE;
+template <typename SampleType>
+Disstortion::InputConversion<SampleType>& Disstortion::inputConversion() {
+    if constexpr (std::is_same_v<SampleType, double>) {
+        return mInputConversion64;
+    } else {
+        return mInputConversion32;
+    }
 }
 
-void Disstortion::processEvents(const clap_input_events* in_events) const {
-    // process parameters
+template <typename SampleType>
+const SampleType* const* Disstortion::inputChannels(const clap_process* process) {
+    if (process->audio_inputs_count == 0) {
+        return nullptr;
+    }
+    const auto& in = process->audio_inputs[0];
+    if (const auto* const* data = channelsData<SampleType>(&in)) {
+        return data;
+    }
+
+    using OtherType = std::conditional_t<std::is_same_v<SampleType, double>, float, double>;
+    const auto* const* other = channelsData<OtherType>(&in);
+    auto& conversion = inputConversion<SampleType>();
+    if (other == nullptr || process->frames_count > conversion.max_frames) {
+        return nullptr;
+    }
+    for (uint32_t ch = 0; ch < inputChannelCount(process); ++ch) {
+        SampleType* converted = conversion.buffer.data() + ch * conversion.max_frames;
+        std::transform(other[ch], other[ch] + process->frames_count, converted,
+                       [](OtherType s) { return static_cast<SampleType>(s); });
+        conversion.channels[ch] = converted;
+    }
+    return conversion.channels.data();
+}
+
+template <typename SampleType>
+Disstortion::GroupsJob<SampleType>& Disstortion::groupsJob() {
+    if constexpr (std::is_same_v<SampleType, double>) {
+        return mGroupsJob64;
+    } else {
+        return mGroupsJob32;
+    }
+}
+
+bool Disstortion::shouldUseThreadPool(uint32_t nb_groups, uint32_t frames) const {
+    // A group costs around 0.2us per frame with the 4x oversampled shapers, against a few microseconds
+    // for the host to wake its workers. Slices shorter than this stay on the audio thread.
+    static constexpr uint32_t kThreadPoolMinFrames = 128;
+    return nb_groups > 1 && frames >= kThreadPoolMinFrames && _host.canUseThreadPool();
+}
+
+void Disstortion::threadPoolExec(uint32_t taskIndex) noexcept {
+    // The pool threads don't share the floating point mode of the audio thread.
+    const dsp::DenormalGuard denormal_guard;
+    if (mGroupsJobIs64) {
+        mGroupsJob64.run(taskIndex);
+    } else {
+        mGroupsJob32.run(taskIndex);
+    }
+}
+
+void Disstortion::processEvents(const clap_input_events* in_events) {
     const auto event_count = in_events->size(in_events);
     for (uint32_t i = 0; i < event_count; ++i) {
-        const auto* event = in_events->get(in_events, i);
-        if (event->space_id == CLAP_CORE_EVENT_SPACE_ID && event->type == CLAP_EVENT_PARAM_VALUE) {
-            auto* param_event = reinterpret_cast<const clap_event_param_value*>(event);
-            if (mParameters.isValidParamId(param_event->param_id)) {
-                LOG_INFO("param", "Processing event for param {}", getParameter(param_event->param_id)->getInfo().name);
-                mParameters.getParamById(param_event->param_id)->setValue(param_event->value);
-            }
+        processEvent(in_events->get(in_events, i));
+    }
+}
+
+void Disstortion::processEvent(const clap_event_header* event) {
+    if (event->space_id != CLAP_CORE_EVENT_SPACE_ID) {
+        return;
+    }
+    // process parameters
+    if (event->type == CLAP_EVENT_PARAM_VALUE) {
+        auto* param_event = reinterpret_cast<const clap_event_param_value*>(event);
+        if (auto* param = mParameters.getParamById(param_event->param_id)) {
+            LOG_INFO("param", "Processing event for param {}", param->getInfo().name);
+            param->setValue(param_event->value);
+        }
+    } else if (event->type == CLAP_EVENT_PARAM_MOD) {
+        // The modulation only goes to the engine, the value seen by the host and the UI doesn't move.
+        auto* mod_event = reinterpret_cast<const clap_event_param_mod*>(event);
+        if (const auto* param = mParameters.getParamById(mod_event->param_id);
+            param && (param->getInfo().flags & CLAP_PARAM_IS_MODULATABLE)) {
+            mParameterSnapshot.setModulation(mod_event->param_id, mod_event->amount);
         }
     }
 }
@@ -175,19 +475,32 @@ bool Disstortion::paramsInfo(uint32_t paramIndex, clap_param_info* info) const n
 }
 
 bool Disstortion::paramsValue(clap_id paramId, double* value) noexcept {
-    *value = mParameters.getParamValue(paramId);
+    const auto* param = mParameters.getParamById(paramId);
+    if (param == nullptr) {
+        return false;
+    }
+    *value = param->getValue();
     return true;
 }
 
 bool Disstortion::paramsValueToText(clap_id paramId, double value, char* display, uint32_t size) noexcept {
-    const auto& value_type = mParameters.getParamValueType(paramId);
-    snprintf(display, size, "%s", value_type.toText(value).c_str());
-    return true;
+    const auto* param = mParameters.getParamById(paramId);
+    if (param == nullptr) {
+        return false;
+    }
+    return param->getValueType().toText(value, display, size);
 }
 
 bool Disstortion::paramsTextToValue(clap_id paramId, const char* display, double* value) noexcept {
-    const auto& value_type = mParameters.getParamValueType(paramId);
-    *value = value_type.toValue(display);
+    const auto* param = mParameters.getParamById(paramId);
+    if (param == nullptr) {
+        return false;
+    }
+    const auto parsed = param->getValueType().toValue(display);
+    if (!parsed) {
+        return false;
+    }
+    *value = *parsed;
     return true;
 }
 
@@ -196,27 +509,68 @@ bool Disstortion::audioPortsInfo(uint32_t index, bool isInput, clap_audio_port_i
         return false;
     }
 
-    if (isInput) {
-        // Input port configuration
-        info->id = 0;
-        snprintf(info->name, sizeof(info->name), "%s", "Audio Input");
-        info->flags = CLAP_AUDIO_PORT_IS_MAIN;
-        info->channel_count = kNbInChannels;
-        info->port_type = CLAP_PORT_STEREO;
-        info->in_place_pair = 0; // Paired with output port 0 for in-place processing
-    } else {
-        // Output port configuration
-        info->id = 0;
-        snprintf(info->name, sizeof(info->name), "%s", "Audio Output");
-        info->flags = CLAP_AUDIO_PORT_IS_MAIN;
-        info->channel_count = kNbOutChannels;
-        info->port_type = CLAP_PORT_STEREO;
-        info->in_place_pair = 0; // Paired with input port 0 for in-place processing
+    const auto& layout = kPortsLayouts[mPortsConfigIndex];
+    info->id = 0;
+    snprintf(info->name, sizeof(info->name), "%s", isInput ? "Audio Input" : "Audio Output");
+    info->flags = CLAP_AUDIO_PORT_IS_MAIN | CLAP_AUDIO_PORT_SUPPORTS_64BITS;
+    info->channel_count = layout.channel_count;
+    info->port_type = layout.port_type;
+    info->in_place_pair = 0; // Input and output ports are paired for in-place processing
+
+    return true;
+}
+
+uint32_t Disstortion::audioPortsConfigCount() const noexcept {
+    return static_cast<uint32_t>(kPortsLayouts.size());
+}
+
+bool Disstortion::audioPortsConfigGet(uint32_t index, clap_audio_ports_config* config) const noexcept {
+    if (index >= kPortsLayouts.size()) {
+        return false;
     }
 
+    const auto& layout = kPortsLayouts[index];
+    config->id = index;
+    snprintf(config->name, sizeof(config->name), "%s", layout.name);
+    config->input_port_count = 1;
+    config->output_port_count = 1;
+    config->has_main_input = true;
+    config->main_input_channel_count = layout.channel_count;
+    config->main_input_port_type = layout.port_type;
+    config->has_main_output = true;
+    config->main_output_channel_count = layout.channel_count;
+    config->main_output_port_type = layout.port_type;
     return true;
 }
 
+bool Disstortion::audioPortsConfigSelect(clap_id configId) noexcept {
+    // Only called while deactivated, the engine is resized on the next activation.
+    if (configId >= kPortsLayouts.size()) {
+        return false;
+    }
+    LOG_INFO("dsp", "[Disstortion::audioPortsConfigSelect] {}", kPortsLayouts[configId].name);
+    mPortsConfigIndex = configId;
+    return true;
+}
+
+bool Disstortion::surroundIsChannelMaskSupported(uint64_t channelMask) const noexcept {
+    return std::any_of(kPortsLayouts.begin(), kPortsLayouts.end(), [channelMask](const PortsLayout& layout) {
+        return isSurround(layout) && stfefane::channelMask(layout) == channelMask;
+    });
+}
+
+uint32_t Disstortion::surroundGetChannelMap(bool, uint32_t portIndex, uint8_t* channelMap,
+                                            uint32_t channelMapCapacity) const noexcept {
+    const auto& layout = kPortsLayouts[mPortsConfigIndex];
+    if (portIndex != 0 || !isSurround(layout)) {
+        return 0;
+    }
+
+    const auto count = std::min(layout.channel_count, channelMapCapacity);
+    std::copy_n(layout.channel_map.begin(), count, channelMap);
+    return count;
+}
+
 bool Disstortion::stateSave(const clap_ostream* stream) noexcept {
     const auto j = mPresetManager->getCurrentState();
     LOG_DEBUG("param", "[stateSave] -> {}", j.dump(4));
@@ -1,11 +1,16 @@
 #pragma once
 
 #include <array>
+#include <atomic>
+#include <memory>
+#include <vector>
 #include <clap/helpers/plugin.hh>
 #include <readerwriterqueue.h>
 
 #include "dsp/MultiDisto.h"
 #include "gui/DisstortionEditor.h"
+#include "params/IParameterListener.h"
+#include "params/ParameterSnapshot.h"
 #include "params/Parameters.h"
 
 namespace stfefane {
@@ -59,6 +64,59 @@ protected:
     bool audioPortsInfo(uint32_t index, bool isInput, clap_audio_port_info* info) const noexcept override;
     /** @} */
 
+    /**
+     * @name audio ports config related methods
+     * @{
+     */
+    [[nodiscard]] bool implementsAudioPortsConfig() const noexcept override { return true; }
+    [[nodiscard]] uint32_t audioPortsConfigCount() const noexcept override;
+    bool audioPortsConfigGet(uint32_t index, clap_audio_ports_config* config) const noexcept override;
+    bool audioPortsConfigSelect(clap_id configId) noexcept override;
+    /** @} */
+
+    /**
+     * @name surround related methods
+     * @{
+     */
+    [[nodiscard]] bool implementsSurround() const noexcept override { return true; }
+    [[nodiscard]] bool surroundIsChannelMaskSupported(uint64_t channelMask) const noexcept override;
+    uint32_t surroundGetChannelMap(bool isInput, uint32_t portIndex, uint8_t* channelMap,
+                                   uint32_t channelMapCapacity) const noexcept override;
+    /** @} */
+
+    /**
+     * @name tail related methods
+     * @{
+     */
+    [[nodiscard]] bool implementsTail() const noexcept override { return true; }
+    [[nodiscard]] uint32_t tailGet() const noexcept override { return mTailSamples; }
+    /** @} */
+
+    /**
+     * @name latency related methods
+     * @{
+     */
+    [[nodiscard]] bool implementsLatency() const noexcept override { return true; }
+    [[nodiscard]] uint32_t latencyGet() const noexcept override { return mReportedLatency; }
+    /** @} */
+
+    /**
+     * @name render related methods
+     * @{
+     */
+    [[nodiscard]] bool implementsRender() const noexcept override { return true; }
+    bool renderHasHardRealtimeRequirement() noexcept override { return false; }
+    bool renderSetMode(clap_plugin_render_mode mode) noexcept override;
+    /** @} */
+
+    /**
+     * @name thread pool related methods
+     * @{
+     */
+    [[nodiscard]] bool implementsThreadPool() const noexcept override { return true; }
+    void threadPoolExec(uint32_t taskIndex) noexcept override;
+    /** @} */
+
     /**
      * @name state related methods
      * @{
@@ -111,21 +169,82 @@ public:
     };
     typedef moodycamel::ReaderWriterQueue<UIEvent, 4096> UIEventsQueue;
 
-    static constexpr uint32_t kNbInChannels = 2;
-    static constexpr uint32_t kNbOutChannels = 2;
+    // Widest bus layout offered (7.1.4)
+    static constexpr uint32_t kMaxChannels = 12;
 
 private:
-    void processEvents(const clap_input_events* in_events) const;
+    // Channel groups of the block being processed, run as separate tasks by the host thread pool.
+    template <typename SampleType>
+    struct GroupsJob {
+        dsp::MultiDisto<SampleType>* processor = nullptr;
+        std::array<const SampleType*, kMaxChannels> in = {};
+        std::array<SampleType*, kMaxChannels> out = {};
+        uint32_t nb_channels = 0;
+        uint32_t frames = 0;
+
+        void run(uint32_t group) const { processor->processGroup(group, in.data(), out.data(), nb_channels, frames); }
+    };
+
+    template <typename SampleType>
+    GroupsJob<SampleType>& groupsJob();
+
+    // Input channels converted to the precision of the engine, for the hosts that pick a different precision for
+    // the input and output ports. Allocated on activation.
+    template <typename SampleType>
+    struct InputConversion {
+        std::vector<SampleType> buffer;
+        std::array<const SampleType*, kMaxChannels> channels = {};
+        uint32_t max_frames = 0;
+    };
+
+    template <typename SampleType>
+    InputConversion<SampleType>& inputConversion();
+    template <typename SampleType>
+    const SampleType* const* inputChannels(const clap_process* process);
+    [[nodiscard]] bool shouldUseThreadPool(uint32_t nb_groups, uint32_t frames) const;
+
+    template <typename SampleType>
+    clap_process_status processWithEngine(const clap_process* process, dsp::MultiDisto<SampleType>& processor);
+    template <typename SampleType>
+    void processAudio(const clap_process* process, const SampleType* const* in_data, uint32_t start, uint32_t end,
+                      dsp::MultiDisto<SampleType>& processor);
+    void processEvents(const clap_input_events* in_events);
+    void processEvent(const clap_event_header* event);
     void handleEventsFromUIQueue(const clap_output_events_t *);
+    void requestAntialiasingRestart();
 
     params::Parameters mParameters;
+    // Values of the parameters used by the processing, adopted at the start of each block
+    params::ParameterSnapshot mParameterSnapshot{mParameters};
     std::unique_ptr<presets::PresetManager> mPresetManager;
+    params::ParameterAttachment mOversamplingAttachment;
+    params::ParameterAttachment mOversamplingMethodAttachment;
+    params::ParameterAttachment mAdaaOrderAttachment;
 
     std::unique_ptr<gui::DisstortionEditor> mEditor;
 
     UIEventsQueue mEventsQueue;
 
-    std::array<dsp::MultiDisto, kNbOutChannels> mDistoProcessors;
+    // One chain per precision, the one matching the host buffers is used.
+    dsp::MultiDisto<float> mDistoProcessor32;
+    dsp::MultiDisto<double> mDistoProcessor64;
+
+    GroupsJob<float> mGroupsJob32;
+    GroupsJob<double> mGroupsJob64;
+    bool mGroupsJobIs64 = false;
+
+    InputConversion<float> mInputConversion32;
+    InputConversion<double> mInputConversion64;
+
+    // Offline renders run the shaping with a higher quality oversampling, applied on activation.
+    clap_plugin_render_mode mRenderMode = CLAP_RENDER_REALTIME;
+    uint32_t mReportedLatency = 0;
+
+    // Index of the selected bus layout, the same one is used for the input and output ports.
+    uint32_t mPortsConfigIndex = 1;
+
+    // Ringing time of the chain for the current settings, refreshed on the audio thread.
+    std::atomic<uint32_t> mTailSamples = 0;
 
 };
 } // namespace stfefane
\ No newline at end of file
@@ -0,0 +1,267 @@
+#pragma once
+
+#include "utils/Utils.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <string_view>
+
+namespace stfefane::dsp {
+
+/**
+ * Antiderivative anti-aliasing (ADAA) of memoryless curves.
+ * Instead of evaluating the curve f at each sample, the output is the average of f between consecutive samples,
+ * computed from its antiderivatives. The averaging acts as a lowpass on the harmonics the curve generates, and
+ * suppresses most of the aliasing at the cost of half a sample (first order) or one sample (second order) of delay.
+ * All the computations run in double, the differences of antiderivatives being badly conditioned in float.
+ */
+enum class AdaaOrder { Off, First, Second };
+
+// Orders offered to the user, in the order of AdaaOrder
+static constexpr std::array<std::string_view, 3> kAdaaOrderNames = {"Off", "1st Order", "2nd Order"};
+
+namespace adaa {
+
+// Below this distance between inputs, the divided differences are replaced by their limit.
+static constexpr double kTolerance = 1e-4;
+
+// Dilogarithm Li2(z) for -1 <= z <= 0.5. The series converges quickly for |z| <= 0.5,
+// the Landen identity Li2(z) = -Li2(z / (z - 1)) - ln(1 - z)^2 / 2 brings [-1, -0.5[ into that range.
+[[nodiscard]] inline double dilogarithm(double z) {
+    if (z < -0.5) {
+        const double log_1mz = std::log1p(-z);
+        return -dilogarithm(z / (z - 1.0)) - 0.5 * log_1mz * log_1mz;
+    }
+    double sum = 0.0;
+    double power = z;
+    for (int k = 1; k < 64; ++k) {
+        const double term = power / (k * k);
+        sum += term;
+        if (std::fabs(term) < 1e-17) {
+            break;
+        }
+        power *= z;
+    }
+    return sum;
+}
+
+// ln(cosh(x)) without overflow for large inputs
+[[nodiscard]] inline double logCosh(double x) {
+    const double ax = std::fabs(x);
+    return ax + std::log1p(std::exp(-2.0 * ax)) - std::numbers::ln2;
+}
+
+// Each curve maps u = input * gain, and provides its first two antiderivatives (zero at u = 0 for the second one).
+// The values must match the process() of the kernels in DistortionKernels.h.
+
+struct CubicCurve {
+    double gain;
+    double a;
+
+    CubicCurve(double drive, double asymmetry) : gain(drive), a(asymmetry) {}
+
+    [[nodiscard]] double value(double u) const {
+        if (std::fabs(u) < 2.0 / 3.0) {
+            return u * (1.0 + a * u);
+        }
+        // Past |u| = 4/3 the curve folds back, its sign can differ from the input one.
+        const double d = 2.0 - 3.0 * std::fabs(u);
+        return (u > 0.0 ? 1.0 : -1.0) * (1.0 - d * d / 3.0);
+    }
+    [[nodiscard]] double antiderivative1(double u) const {
+        if (std::fabs(u) < 2.0 / 3.0) {
+            return u * u * (0.5 + a * u / 3.0);
+        }
+        const double d = 2.0 - 3.0 * std::fabs(u);
+        return std::fabs(u) + d * d * d / 27.0 - 4.0 / 9.0 + std::copysign(8.0 / 81.0, u) * a;
+    }
+    [[nodiscard]] double antiderivative2(double u) const {
+        const double u2 = u * u;
+        if (std::fabs(u) < 2.0 / 3.0) {
+            return u2 * u * (1.0 / 6.0 + a * u / 12.0);
+        }
+        // Integration constants keeping both antiderivatives continuous at +-2/3
+        const double sign = u > 0.0 ? 1.0 : -1.0;
+        const double c = sign * 8.0 / 81.0 * a - 4.0 / 9.0;
+        const double d = 2.0 - 3.0 * std::fabs(u);
+        const double d4 = d * d * d * d;
+        return sign * (0.5 * u2 - d4 / 324.0 + 4.0 / 81.0 - 2.0 / 9.0) + c * u - 2.0 * sign * c / 3.0 + 4.0 * a / 243.0;
+    }
+};
+
+struct TubeCurve {
+    double gain;
+    double g;
+    double norm;
+
+    TubeCurve(double drive, double asymmetry)
+    : gain(drive), g(std::max(1e-6, 0.7 * (1.0 + asymmetry))), norm(std::tanh(g)) {}
+
+    [[nodiscard]] double value(double u) const { return std::tanh(g * u) / norm; }
+    [[nodiscard]] double antiderivative1(double u) const { return logCosh(g * u) / (g * norm); }
+    [[nodiscard]] double antiderivative2(double u) const {
+        // Integral of ln(cosh(v)) from 0: v^2 / 2 - v ln(2) + Li2(-e^-2v) / 2 + pi^2 / 24, odd in v
+        const double v = std::fabs(g * u);
+        const double integral = 0.5 * v * v - v * std::numbers::ln2 + 0.5 * dilogarithm(-std::exp(-2.0 * v))
+                              + utils::kPI_64 * utils::kPI_64 / 24.0;
+        return std::copysign(integral, u) / (g * g * norm);
+    }
+};
+
+struct AsymmetricClipCurve {
+    double gain;
+    double threshold;
+
+    AsymmetricClipCurve(double drive, double asymmetry) : gain(drive), threshold(0.7 + 0.3 * asymmetry) {}
+
+    [[nodiscard]] double value(double u) const {
+        if (std::fabs(u) <= threshold) {
+            return u;
+        }
+        return std::copysign(threshold, u) + (u - std::copysign(threshold, u)) * 0.1;
+    }
+    [[nodiscard]] double antiderivative1(double u) const {
+        const double v = std::fabs(u);
+        if (v <= threshold) {
+            return 0.5 * u * u;
+        }
+        return threshold * v + 0.05 * (v - threshold) * (v - threshold) - 0.5 * threshold * threshold;
+    }
+    [[nodiscard]] double antiderivative2(double u) const {
+        const double v = std::fabs(u);
+        if (v <= threshold) {
+            return u * u * u / 6.0;
+        }
+        const double t = threshold;
+        const double e = v - t;
+        return std::copysign(0.5 * t * v * v + e * e * e / 60.0 - 0.5 * t * t * v + t * t * t / 6.0, u);
+    }
+};
+
+struct WaveShaperCurve {
+    double gain;
+    double k;
+
+    WaveShaperCurve(double drive, double) : gain(drive), k(2.0 * drive) {}
+
+    [[nodiscard]] double value(double u) const { return u * (1.0 + k) / (1.0 + k * std::fabs(u)); }
+    [[nodiscard]] double antiderivative1(double u) const {
+        const double v = std::fabs(u);
+        return (1.0 + k) * (v / k - std::log1p(k * v) / (k * k));
+    }
+    [[nodiscard]] double antiderivative2(double u) const {
+        const double v = std::fabs(u);
+        const double kv = k * v;
+        return std::copysign((1.0 + k) * (0.5 * v * v / k - ((1.0 + kv) * std::log1p(kv) - kv) / (k * k * k)), u);
+    }
+};
+
+struct TubeScreamerCurve {
+    double gain;
+
+    TubeScreamerCurve(double drive, double) : gain(2.0 * drive) {}
+
+    [[nodiscard]] double value(double u) const {
+        const double v = std::fabs(u);
+        if (v < 1.0 / 3.0) {
+            return 2.0 * u;
+        }
+        if (v < 2.0 / 3.0) {
+            const double d = 2.0 - 3.0 * v;
+            return std::copysign((3.0 - d * d) / 3.0, u);
+        }
+        return std::copysign(1.0, u);
+    }
+    [[nodiscard]] double antiderivative1(double u) const {
+        const double v = std::fabs(u);
+        if (v < 1.0 / 3.0) {
+            return v * v;
+        }
+        if (v < 2.0 / 3.0) {
+            const double d = 2.0 - 3.0 * v;
+            return v + d * d * d / 27.0 - 7.0 / 27.0;
+        }
+        return v - 7.0 / 27.0;
+    }
+    [[nodiscard]] double antiderivative2(double u) const {
+        const double v = std::fabs(u);
+        if (v < 1.0 / 3.0) {
+            return u * u * u / 3.0;
+        }
+        double integral = 0.5 * v * v - 7.0 * v / 27.0 + 5.0 / 108.0;
+        if (v < 2.0 / 3.0) {
+            const double d = 2.0 - 3.0 * v;
+            integral -= d * d * d * d / 324.0;
+        }
+        return std::copysign(integral, u);
+    }
+};
+
+// Past inputs of a curve for one channel, and the values derived from them that are reused by the next sample.
+// The cached values depend on the curve parameters, refresh() recomputes them when these change.
+struct State {
+    double x1 = 0.0;
+    double x2 = 0.0;
+    // First order: first antiderivative at x1
+    double ad1 = 0.0;
+    // Second order: second antiderivative at x1, and divided difference of it between x2 and x1
+    double ad2 = 0.0;
+    double diff = 0.0;
+};
+
+template <typename Curve>
+[[nodiscard]] double dividedDifference(const Curve& curve, double x, double ad2_x, double x1, double ad2_x1) {
+    const double dx = x - x1;
+    if (std::fabs(dx) < kTolerance) {
+        return curve.antiderivative1(0.5 * (x + x1));
+    }
+    return (ad2_x - ad2_x1) / dx;
+}
+
+template <AdaaOrder order, typename Curve>
+void refresh(const Curve& curve, State& state) {
+    if constexpr (order == AdaaOrder::First) {
+        state.ad1 = curve.antiderivative1(state.x1);
+    } else {
+        state.ad2 = curve.antiderivative2(state.x1);
+        state.diff = dividedDifference(curve, state.x1, state.ad2, state.x2, curve.antiderivative2(state.x2));
+    }
+}
+
+// Processes one input of the curve (already multiplied by the curve gain)
+template <AdaaOrder order, typename Curve>
+[[nodiscard]] double process(const Curve& curve, State& state, double x) {
+    if constexpr (order == AdaaOrder::First) {
+        const double ad1 = curve.antiderivative1(x);
+        const double dx = x - state.x1;
+        const double y = std::fabs(dx) < kTolerance ? curve.value(0.5 * (x + state.x1)) : (ad1 - state.ad1) / dx;
+        state.x1 = x;
+        state.ad1 = ad1;
+        return y;
+    } else {
+        const double ad2 = curve.antiderivative2(x);
+        const double diff = dividedDifference(curve, x, ad2, state.x1, state.ad2);
+        double y;
+        if (const double dx2 = x - state.x2; std::fabs(dx2) >= kTolerance) {
+            y = 2.0 * (diff - state.diff) / dx2;
+        } else {
+            // The input came back to x2, take the limit around the middle of x and x2
+            const double x_mid = 0.5 * (x + state.x2);
+            const double delta = x_mid - state.x1;
+            if (std::fabs(delta) < kTolerance) {
+                y = curve.value(0.5 * (x_mid + state.x1));
+            } else {
+                y = 2.0 / delta * (curve.antiderivative1(x_mid) + (state.ad2 - curve.antiderivative2(x_mid)) / delta);
+            }
+        }
+        state.x2 = state.x1;
+        state.x1 = x;
+        state.ad2 = ad2;
+        state.diff = diff;
+        return y;
+    }
+}
+
+} // namespace adaa
+
+} // namespace stfefane::dsp
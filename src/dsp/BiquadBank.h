@@ -0,0 +1,205 @@
+#pragma once
+
+#include "Simd.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace stfefane::dsp {
+
+// Coefficients of a biquad normalized so that a0 == 1, always designed in double precision.
+struct BiquadCoefficients {
+    double b0 = 1.0;
+    double b1 = 0.0;
+    double b2 = 0.0;
+    double a1 = 0.0;
+    double a2 = 0.0;
+
+    // Group delay at DC in samples, from the centroid of the numerator and denominator coefficients
+    [[nodiscard]] double groupDelayAtDc() const {
+        const double num = b0 + b1 + b2;
+        const double den = 1.0 + a1 + a2;
+        if (num == 0.0 || den == 0.0) {
+            return 0.0;
+        }
+        return (b1 + 2.0 * b2) / num - (a1 + 2.0 * a2) / den;
+    }
+
+    // Number of samples for the impulse response to decay by the given ratio, from the radius of the poles
+    [[nodiscard]] double decaySamples(double ratio) const {
+        const double disc = a1 * a1 - 4.0 * a2;
+        const double radius = disc < 0.0 ? std::sqrt(a2) : 0.5 * (std::abs(a1) + std::sqrt(disc));
+        if (radius <= 0.0) {
+            return 0.0;
+        }
+        return std::log(ratio) / std::log(std::min(radius, 1.0 - 1e-9));
+    }
+};
+
+// Per sample coefficients of a filter over a block, one array per coefficient (SoA)
+template <typename Scalar>
+using CoefficientRamp = std::array<const Scalar*, 5>;
+
+/**
+ * Cascade of up to kMaxStages biquads in Transposed Direct Form II, with the coefficients and states stored
+ * stage by stage (SoA) so that the stages are updated together.
+ * SampleType can be a Lanes group, the bank then covers channels x stages: each stage shares its coefficients
+ * across the lanes.
+ * In a plain cascade each stage waits for the output of the previous one. The bank skews the stages instead,
+ * stage s processing sample t - s at step t, which makes the updates of a step independent of each other.
+ * The result is the same as the plain cascade, the skew is resolved inside each buffer and adds no latency.
+ */
+template <typename SampleType, std::size_t kMaxStages>
+class BiquadBank {
+public:
+    using Scalar = ScalarOf<SampleType>;
+
+    BiquadBank() {
+        for (uint32_t s = 0; s < kMaxStages; ++s) {
+            setCoefficients(s, {});
+        }
+    }
+
+    // Number of cascaded stages in use, the others are skipped
+    void setNbStages(uint32_t nb_stages) {
+        mNbStages = std::min<uint32_t>(nb_stages, kMaxStages);
+        reset();
+    }
+
+    [[nodiscard]] uint32_t getNbStages() const { return mNbStages; }
+
+    void setCoefficients(uint32_t stage, const BiquadCoefficients& c) {
+        mDesign[stage] = c;
+        mB0[stage] = static_cast<Scalar>(c.b0);
+        mB1[stage] = static_cast<Scalar>(c.b1);
+        mB2[stage] = static_cast<Scalar>(c.b2);
+        mA1[stage] = static_cast<Scalar>(c.a1);
+        mA2[stage] = static_cast<Scalar>(c.a2);
+    }
+
+    [[nodiscard]] const BiquadCoefficients& getCoefficients(uint32_t stage) const { return mDesign[stage]; }
+
+    void reset() {
+        mZ1 = {};
+        mZ2 = {};
+    }
+
+    // Process a buffer in-place through the whole cascade
+    void processBuffer(SampleType* samples, std::size_t count) {
+        if (mNbStages == 0 || count == 0) {
+            return;
+        }
+        if (mNbStages == 1) {
+            for (std::size_t i = 0; i < count; ++i) {
+                samples[i] = processStage(0, samples[i]);
+            }
+            return;
+        }
+
+        // Inputs of the stages for the current step, stage s receiving the output of stage s - 1 at the previous one.
+        // At the start (end) of the buffer the last (first) stages have nothing to process yet (anymore).
+        const std::size_t last_stage = mNbStages - 1;
+        std::array<SampleType, kMaxStages> input = {};
+        std::array<SampleType, kMaxStages> output = {};
+        for (std::size_t t = 0; t < count + last_stage; ++t) {
+            const std::size_t first = t < count ? 0 : t - count + 1;
+            const std::size_t last = std::min(t, last_stage);
+            if (t < count) {
+                input[0] = samples[t];
+            }
+            for (std::size_t s = first; s <= last; ++s) {
+                const SampleType y = mB0[s] * input[s] + mZ1[s];
+                mZ1[s] = mB1[s] * input[s] - mA1[s] * y + mZ2[s];
+                mZ2[s] = mB2[s] * input[s] - mA2[s] * y;
+                output[s] = y;
+            }
+            for (std::size_t s = first; s <= last && s < last_stage; ++s) {
+                input[s + 1] = output[s];
+            }
+            if (last == last_stage) {
+                samples[t - last_stage] = output[last_stage];
+            }
+        }
+    }
+
+    // Process a buffer in-place through the first stage, with the coefficients {b0, b1, b2, a1, a2} of each sample.
+    // The interpolation of the coefficients between stable designs stays stable, the stability triangle being convex.
+    void processBuffer(SampleType* samples, const CoefficientRamp<Scalar>& coefficients, std::size_t count) {
+        const auto [b0, b1, b2, a1, a2] = coefficients;
+        SampleType z1 = mZ1[0];
+        SampleType z2 = mZ2[0];
+        for (std::size_t i = 0; i < count; ++i) {
+            const SampleType x = samples[i];
+            const SampleType y = b0[i] * x + z1;
+            z1 = b1[i] * x - a1[i] * y + z2;
+            z2 = b2[i] * x - a2[i] * y;
+            samples[i] = y;
+        }
+        mZ1[0] = z1;
+        mZ2[0] = z2;
+    }
+
+    // Process a single sample through the whole cascade
+    SampleType process(SampleType x) {
+        for (uint32_t s = 0; s < mNbStages; ++s) {
+            x = processStage(s, x);
+        }
+        return x;
+    }
+
+    // True when the state of every stage has decayed below the threshold on every lane
+    [[nodiscard]] bool isQuiet(Scalar threshold) const {
+        for (uint32_t s = 0; s < mNbStages; ++s) {
+            if (maxAbs(mZ1[s]) >= threshold || maxAbs(mZ2[s]) >= threshold) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Group delay at DC of the cascade, in samples
+    [[nodiscard]] double groupDelayAtDc() const {
+        double delay = 0.0;
+        for (uint32_t s = 0; s < mNbStages; ++s) {
+            delay += mDesign[s].groupDelayAtDc();
+        }
+        return delay;
+    }
+
+    // Number of samples for the impulse response of the cascade to decay by the given ratio
+    [[nodiscard]] double decaySamples(double ratio) const {
+        double decay = 0.0;
+        for (uint32_t s = 0; s < mNbStages; ++s) {
+            decay += mDesign[s].decaySamples(ratio);
+        }
+        return decay;
+    }
+
+private:
+    inline SampleType processStage(std::size_t s, SampleType x) {
+        // TDF2: y = b0*x + z1; z1 = b1*x - a1*y + z2; z2 = b2*x - a2*y
+        const SampleType y = mB0[s] * x + mZ1[s];
+        // Denormals are flushed by the DenormalGuard set around the processing.
+        mZ1[s] = mB1[s] * x - mA1[s] * y + mZ2[s];
+        mZ2[s] = mB2[s] * x - mA2[s] * y;
+        return y;
+    }
+
+    uint32_t mNbStages = 1;
+
+    // Coefficients of each stage, a0 is implicitly 1. The double ones are kept for the latency and tail estimates.
+    std::array<BiquadCoefficients, kMaxStages> mDesign = {};
+    std::array<Scalar, kMaxStages> mB0 = {};
+    std::array<Scalar, kMaxStages> mB1 = {};
+    std::array<Scalar, kMaxStages> mB2 = {};
+    std::array<Scalar, kMaxStages> mA1 = {};
+    std::array<Scalar, kMaxStages> mA2 = {};
+
+    // TDF2 states of each stage
+    std::array<SampleType, kMaxStages> mZ1 = {};
+    std::array<SampleType, kMaxStages> mZ2 = {};
+};
+
+} // namespace stfefane::dsp
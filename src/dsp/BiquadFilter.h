@@ -1,38 +1,240 @@
 #pragma once
 
+#include "BiquadBank.h"
+#include "FastMath.h"
+#include "Simd.h"
 #include "utils/Utils.h"
+#include <algorithm>
 #include <array>
-#include <vector>
+#include <cmath>
+#include <numbers>
+#include <string_view>
 
 namespace stfefane::dsp {
 
-// A fresh, stable biquad filter implementation based on
-// the "Audio EQ Cookbook" by Robert Bristow-Johnson (RBJ).
+enum class FilterType {
+    None,
+    LowPass,
+    HighPass,
+    BandPass,
+    Notch,
+    Peak,
+    AllPass,
+    LowShelf,
+    HighShelf
+};
+
+static constexpr std::array<std::string_view, 8> kFilterTypeNames = {
+    "LowPass", "HighPass", "BandPass", "Notch", "Peak", "AllPass", "LowShelf", "HighShelf"
+};
+
+namespace detail {
+
+// Frequency in Hz clamped to ]0, 0.99 * Nyquist], as a fraction of the sample rate
+[[nodiscard]] inline double normalizedFrequency(double sampleRate, double freq) {
+    const double nyquist = 0.5 * sampleRate;
+    double f = freq;
+    if (f <= 0.0) {
+        f = 1.0; // prevent zero/negative
+    }
+    if (f > nyquist * 0.99) {
+        f = nyquist * 0.99; // safety clamp under Nyquist
+    }
+    return f / sampleRate;
+}
+
+// RBJ formulas from the cosine and sine of w0, and A = 10^(gainDb / 40)
+[[nodiscard]] inline BiquadCoefficients designBiquad(FilterType type, double cw, double sw, double A, double q) {
+    // For Q <= 0 treat as minimum Q
+    const double Q = (q > 1e-6) ? q : 1e-6;
+    const double alpha = sw / (2.0 * Q);
+
+    double b0{}, b1{}, b2{}, a0{}, a1{}, a2{};
+
+    switch (type) {
+    case FilterType::LowPass:
+        b0 = (1 - cw) * 0.5;
+        b1 = 1 - cw;
+        b2 = (1 - cw) * 0.5;
+        a0 = 1 + alpha;
+        a1 = -2 * cw;
+        a2 = 1 - alpha;
+        break;
+    case FilterType::HighPass:
+        b0 = (1 + cw) * 0.5;
+        b1 = -(1 + cw);
+        b2 = (1 + cw) * 0.5;
+        a0 = 1 + alpha;
+        a1 = -2 * cw;
+        a2 = 1 - alpha;
+        break;
+    case FilterType::BandPass:
+        b0 = sw * 0.5; // constant skirt gain, peak gain = Q
+        b1 = 0.0;
+        b2 = -sw * 0.5;
+        a0 = 1 + alpha;
+        a1 = -2 * cw;
+        a2 = 1 - alpha;
+        break;
+    case FilterType::Notch:
+        b0 = 1;
+        b1 = -2 * cw;
+        b2 = 1;
+        a0 = 1 + alpha;
+        a1 = -2 * cw;
+        a2 = 1 - alpha;
+        break;
+    case FilterType::AllPass:
+        b0 = 1 - alpha;
+        b1 = -2 * cw;
+        b2 = 1 + alpha;
+        a0 = 1 + alpha;
+        a1 = -2 * cw;
+        a2 = 1 - alpha;
+        break;
+    case FilterType::Peak: {
+        const double alphaA = alpha * A;
+        const double alphaDivA = alpha / A;
+        b0 = 1 + alphaA;
+        b1 = -2 * cw;
+        b2 = 1 - alphaA;
+        a0 = 1 + alphaDivA;
+        a1 = -2 * cw;
+        a2 = 1 - alphaDivA;
+        break;
+    }
+    case FilterType::LowShelf: {
+        const double sqrtA = std::sqrt(A);
+        const double twoSqrtAAlpha = 2.0 * sqrtA * alpha;
+        b0 = A * ((A + 1) - (A - 1) * cw + twoSqrtAAlpha);
+        b1 = 2 * A * ((A - 1) - (A + 1) * cw);
+        b2 = A * ((A + 1) - (A - 1) * cw - twoSqrtAAlpha);
+        a0 = (A + 1) + (A - 1) * cw + twoSqrtAAlpha;
+        a1 = -2 * ((A - 1) + (A + 1) * cw);
+        a2 = (A + 1) + (A - 1) * cw - twoSqrtAAlpha;
+        break;
+    }
+    case FilterType::HighShelf: {
+        const double sqrtA = std::sqrt(A);
+        const double twoSqrtAAlpha = 2.0 * sqrtA * alpha;
+        b0 = A * ((A + 1) + (A - 1) * cw + twoSqrtAAlpha);
+        b1 = -2 * A * ((A - 1) + (A + 1) * cw);
+        b2 = A * ((A + 1) + (A - 1) * cw - twoSqrtAAlpha);
+        a0 = (A + 1) - (A - 1) * cw + twoSqrtAAlpha;
+        a1 = 2 * ((A - 1) - (A + 1) * cw);
+        a2 = (A + 1) - (A - 1) * cw - twoSqrtAAlpha;
+        break;
+    }
+    case FilterType::None:
+        // handled earlier
+        b0 = 1;
+        b1 = 0;
+        b2 = 0;
+        a0 = 1;
+        a1 = 0;
+        a2 = 0;
+        break;
+    }
+
+    // Normalize so a0 == 1
+    const double invA0 = (a0 != 0.0) ? (1.0 / a0) : 1.0;
+    return {b0 * invA0, b1 * invA0, b2 * invA0, a1 * invA0, a2 * invA0};
+}
+
+} // namespace detail
+
+// Biquad design based on the "Audio EQ Cookbook" by Robert Bristow-Johnson (RBJ).
+// Coefficients are designed in double precision and normalized so that a0 == 1.
+// None, or an invalid sample rate, gives a bypass.
+[[nodiscard]] inline BiquadCoefficients designBiquad(FilterType type, double sampleRate, double freq, double q = 0.707,
+                                                     double gainDb = 0.0) {
+    if (type == FilterType::None || sampleRate <= 0.0) {
+        return {};
+    }
+    const double w0 = utils::kTWO_PI_64 * detail::normalizedFrequency(sampleRate, freq);
+    const double A = std::pow(10.0, gainDb / 40.0); // for shelving/peak
+    return detail::designBiquad(type, std::cos(w0), std::sin(w0), A, q);
+}
+
+/**
+ * Cosine and sine of w0 = 2 pi f / fs on a logarithmic grid of normalized frequencies, 64 points per octave.
+ * The grid is indexed from the binary exponent and mantissa of the frequency, with no log call. The angle addition
+ * formulas correct the distance to the grid point, with Taylor series of its cosine and sine: for distances
+ * below 0.025 radians the results are exact to 1e-12.
+ */
+class LogFrequencyTrigTable {
+public:
+    static const LogFrequencyTrigTable& instance() {
+        static const LogFrequencyTrigTable table;
+        return table;
+    }
+
+    // Cosine and sine of 2 pi * normalized_freq, for normalized frequencies up to 0.5
+    void cosSin(double normalized_freq, double& c, double& s) const {
+        int exponent = 0;
+        const double mantissa = std::frexp(std::clamp(normalized_freq, kMinFrequency, 0.5), &exponent);
+        const int octave = std::clamp(exponent + kNbOctaves, 0, kNbOctaves - 1);
+        const int step = std::min(static_cast<int>((mantissa - 0.5) * 2.0 * kPointsPerOctave), kPointsPerOctave - 1);
+        const Point& point = mPoints[static_cast<std::size_t>(octave * kPointsPerOctave + step)];
+
+        const double d = utils::kTWO_PI_64 * normalized_freq - point.w;
+        const double d2 = d * d;
+        const double cos_d = 1.0 - d2 * (0.5 - d2 * (1.0 / 24.0 - d2 / 720.0));
+        const double sin_d = d * (1.0 - d2 * (1.0 / 6.0 - d2 / 120.0));
+        c = point.c * cos_d - point.s * sin_d;
+        s = point.s * cos_d + point.c * sin_d;
+    }
+
+private:
+    static constexpr int kPointsPerOctave = 64;
+    // From 2^-19 (0.08Hz at 44.1kHz) up to Nyquist
+    static constexpr int kNbOctaves = 19;
+    static constexpr double kMinFrequency = 1.0 / (1 << kNbOctaves);
+
+    struct Point {
+        double w, c, s;
+    };
+
+    LogFrequencyTrigTable() {
+        // Octave o covers [2^(o - 19), 2^(o - 18)[, split in equal steps of mantissa
+        for (int octave = 0; octave < kNbOctaves; ++octave) {
+            for (int step = 0; step < kPointsPerOctave; ++step) {
+                const double mantissa = 0.5 + 0.5 * step / kPointsPerOctave;
+                const double w = utils::kTWO_PI_64 * std::ldexp(mantissa, octave - kNbOctaves);
+                mPoints[static_cast<std::size_t>(octave * kPointsPerOctave + step)] = {w, std::cos(w), std::sin(w)};
+            }
+        }
+    }
+
+    std::array<Point, kPointsPerOctave * kNbOctaves> mPoints = {};
+};
+
+// Same design as designBiquad, for the control rate updates: the trigonometry comes from LogFrequencyTrigTable
+// and A from fastmath::exp, which leaves no libm call.
+[[nodiscard]] inline BiquadCoefficients designBiquadFast(FilterType type, double sampleRate, double freq,
+                                                         double q = 0.707, double gainDb = 0.0) {
+    if (type == FilterType::None || sampleRate <= 0.0) {
+        return {};
+    }
+    double cw = 1.0;
+    double sw = 0.0;
+    LogFrequencyTrigTable::instance().cosSin(detail::normalizedFrequency(sampleRate, freq), cw, sw);
+    const double A = gainDb == 0.0 ? 1.0 : fastmath::exp(gainDb * (std::numbers::ln10 / 40.0));
+    return detail::designBiquad(type, cw, sw, A, q);
+}
+
+// A fresh, stable biquad filter implementation based on the RBJ designs above.
 //
 // Implementation notes:
-// - Coefficients are normalized so that a0 == 1.
-// - Processing uses Transposed Direct Form II for better numerical stability.
-// - Denormal protection is applied to the state to avoid CPU spikes.
+// - Coefficients are always designed in double precision, then stored in the SampleType used for processing.
+// - SampleType can be a Lanes group, in which case all lanes share the coefficients and run in parallel.
+// - Processing runs on a single stage BiquadBank, in Transposed Direct Form II for better numerical stability.
+// - Denormals in the state are flushed by the FPU, see DenormalGuard.
 // - Supports common types including shelves and allpass.
+template <typename SampleType>
 class BiquadFilter {
 public:
-    enum class Type {
-        None,
-        LowPass,
-        HighPass,
-        BandPass,
-        Notch,
-        Peak,
-        AllPass,
-        LowShelf,
-        HighShelf
-    };
-
-    static constexpr std::vector<std::string> types() {
-        return {
-            "LowPass", "HighPass", "BandPass", "Notch", "Peak", "AllPass", "LowShelf", "HighShelf"
-        };
-    }
+    using Type = FilterType;
 
     BiquadFilter() = default;
 
@@ -81,178 +283,42 @@ public:
     [[nodiscard]] double getQ() const { return mQ; }
     [[nodiscard]] double getGainDb() const { return mGainDb; }
 
-    void reset() {
-        mZ1 = 0.0;
-        mZ2 = 0.0;
-    }
+    void reset() { mBank.reset(); }
 
     // Process a single sample
-    inline double process(double x) {
-        // TDF2: y = b0*x + z1; z1 = b1*x - a1*y + z2; z2 = b2*x - a2*y
-        const double y = mB0 * x + mZ1;
-        const double newZ1 = mB1 * x - mA1 * y + mZ2;
-        const double newZ2 = mB2 * x - mA2 * y;
-
-        // Denormal protection
-        mZ1 = denormProtect(newZ1);
-        mZ2 = denormProtect(newZ2);
-        return y;
-    }
+    inline SampleType process(SampleType x) { return mBank.process(x); }
 
-    // Process a buffer in-place (double)
-    void processBuffer(double* samples, std::size_t count) {
-        for (std::size_t i = 0; i < count; ++i) {
-            samples[i] = process(samples[i]);
-        }
-    }
+    // Process a buffer in-place
+    void processBuffer(SampleType* samples, std::size_t count) { mBank.processBuffer(samples, count); }
 
-    // Process a buffer in-place (float)
-    void processBuffer(float* samples, std::size_t count) {
-        for (std::size_t i = 0; i < count; ++i) {
-            samples[i] = static_cast<float>(process(samples[i]));
-        }
+    // Process a buffer in-place with the coefficients {b0, b1, b2, a1, a2} of each sample, the ones of the filter
+    // being left untouched.
+    void processBuffer(SampleType* samples, const CoefficientRamp<ScalarOf<SampleType>>& coefficients, std::size_t count) {
+        mBank.processBuffer(samples, coefficients, count);
     }
 
-    // Returns current coefficients [b0, b1, b2, a1, a2] where a0 == 1
-    [[nodiscard]] std::array<double, 5> getCoefficients() const { return {mB0, mB1, mB2, mA1, mA2}; }
-
-    // Recompute coefficients using RBJ cookbook (a0 normalized to 1)
-    void updateCoefficients() {
-        if (mType == Type::None || mSampleRate <= 0.0) {
-            // Bypass
-            mB0 = 1.0;
-            mB1 = 0.0;
-            mB2 = 0.0;
-            mA1 = 0.0;
-            mA2 = 0.0;
-            return;
-        }
+    // True when the filter state has decayed below the threshold on every lane
+    [[nodiscard]] bool isQuiet(ScalarOf<SampleType> threshold) const { return mBank.isQuiet(threshold); }
 
-        const double nyquist = 0.5 * mSampleRate;
-        double f = mFreq;
-        if (f <= 0.0) {
-            f = 1.0; // prevent zero/negative
-        }
-        if (f > nyquist * 0.99) {
-            f = nyquist * 0.99; // safety clamp under Nyquist
-        }
+    // Group delay at DC in samples, from the centroid of the numerator and denominator coefficients
+    [[nodiscard]] double groupDelayAtDc() const { return mBank.groupDelayAtDc(); }
 
-        const double w0 = 2.0 * utils::kPI * (f / mSampleRate);
-        const double cw = std::cos(w0);
-        const double sw = std::sin(w0);
-        const double A = std::pow(10.0, mGainDb / 40.0); // for shelving/peak
-
-        // For Q <= 0 treat as minimum Q
-        const double Q = (mQ > 1e-6) ? mQ : 1e-6;
-        const double alpha = sw / (2.0 * Q);
-
-        double b0{}, b1{}, b2{}, a0{}, a1{}, a2{};
-
-        switch (mType) {
-        case Type::LowPass:
-            b0 = (1 - cw) * 0.5;
-            b1 = 1 - cw;
-            b2 = (1 - cw) * 0.5;
-            a0 = 1 + alpha;
-            a1 = -2 * cw;
-            a2 = 1 - alpha;
-            break;
-        case Type::HighPass:
-            b0 = (1 + cw) * 0.5;
-            b1 = -(1 + cw);
-            b2 = (1 + cw) * 0.5;
-            a0 = 1 + alpha;
-            a1 = -2 * cw;
-            a2 = 1 - alpha;
-            break;
-        case Type::BandPass:
-            b0 = sw * 0.5; // constant skirt gain, peak gain = Q
-            b1 = 0.0;
-            b2 = -sw * 0.5;
-            a0 = 1 + alpha;
-            a1 = -2 * cw;
-            a2 = 1 - alpha;
-            break;
-        case Type::Notch:
-            b0 = 1;
-            b1 = -2 * cw;
-            b2 = 1;
-            a0 = 1 + alpha;
-            a1 = -2 * cw;
-            a2 = 1 - alpha;
-            break;
-        case Type::AllPass:
-            b0 = 1 - alpha;
-            b1 = -2 * cw;
-            b2 = 1 + alpha;
-            a0 = 1 + alpha;
-            a1 = -2 * cw;
-            a2 = 1 - alpha;
-            break;
-        case Type::Peak: {
-            const double alphaA = alpha * A;
-            const double alphaDivA = alpha / A;
-            b0 = 1 + alphaA;
-            b1 = -2 * cw;
-            b2 = 1 - alphaA;
-            a0 = 1 + alphaDivA;
-            a1 = -2 * cw;
-            a2 = 1 - alphaDivA;
-            break;
-        }
-        case Type::LowShelf: {
-            const double sqrtA = std::sqrt(A);
-            const double twoSqrtAAlpha = 2.0 * sqrtA * alpha;
-            b0 = A * ((A + 1) - (A - 1) * cw + twoSqrtAAlpha);
-            b1 = 2 * A * ((A - 1) - (A + 1) * cw);
-            b2 = A * ((A + 1) - (A - 1) * cw - twoSqrtAAlpha);
-            a0 = (A + 1) + (A - 1) * cw + twoSqrtAAlpha;
-            a1 = -2 * ((A - 1) + (A + 1) * cw);
-            a2 = (A + 1) + (A - 1) * cw - twoSqrtAAlpha;
-            break;
-        }
-        case Type::HighShelf: {
-            const double sqrtA = std::sqrt(A);
-            const double twoSqrtAAlpha = 2.0 * sqrtA * alpha;
-            b0 = A * ((A + 1) + (A - 1) * cw + twoSqrtAAlpha);
-            b1 = -2 * A * ((A - 1) + (A + 1) * cw);
-            b2 = A * ((A + 1) + (A - 1) * cw - twoSqrtAAlpha);
-            a0 = (A + 1) - (A - 1) * cw + twoSqrtAAlpha;
-            a1 = 2 * ((A - 1) - (A + 1) * cw);
-            a2 = (A + 1) - (A - 1) * cw - twoSqrtAAlpha;
-            break;
-        }
-        case Type::None:
-            // handled earlier
-            b0 = 1;
-            b1 = 0;
-            b2 = 0;
-            a0 = 1;
-            a1 = 0;
-            a2 = 0;
-            break;
-        }
-
-        // Normalize so a0 == 1
-        const double invA0 = (a0 != 0.0) ? (1.0 / a0) : 1.0;
-        mB0 = b0 * invA0;
-        mB1 = b1 * invA0;
-        mB2 = b2 * invA0;
-        mA1 = a1 * invA0;
-        mA2 = a2 * invA0;
-    }
+    // Number of samples for the impulse response to decay by the given ratio, from the radius of the poles
+    [[nodiscard]] double decaySamples(double ratio) const { return mBank.decaySamples(ratio); }
 
-private:
-    static inline double denormProtect(double v) {
-        // Add very tiny DC offset removal behavior: flush to zero
-        return (std::fabs(v) < 1e-30) ? 0.0 : v;
+    // Returns current coefficients [b0, b1, b2, a1, a2] where a0 == 1
+    [[nodiscard]] std::array<ScalarOf<SampleType>, 5> getCoefficients() const {
+        using Scalar = ScalarOf<SampleType>;
+        const auto& c = mBank.getCoefficients(0);
+        return {static_cast<Scalar>(c.b0), static_cast<Scalar>(c.b1), static_cast<Scalar>(c.b2),
+                static_cast<Scalar>(c.a1), static_cast<Scalar>(c.a2)};
     }
 
-    // Coefficients, a0 is implicitly 1
-    double mB0{1.0}, mB1{0.0}, mB2{0.0}, mA1{0.0}, mA2{0.0};
+    // Recompute coefficients using RBJ cookbook (a0 normalized to 1)
+    void updateCoefficients() { mBank.setCoefficients(0, designBiquad(mType, mSampleRate, mFreq, mQ, mGainDb)); }
 
-    // States for TDF2
-    double mZ1{0.0}, mZ2{0.0};
+private:
+    BiquadBank<SampleType, 1> mBank;
 
     // Parameters
     Type mType{Type::None};
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "Simd.h"
+#include "utils/Utils.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+namespace stfefane::dsp {
+
+/**
+ * Bit depth and sample rate reduction, driven by the distortion drive.
+ * The quantiser and the hold length only depend on the drive, they are recomputed when it changes.
+ * The hold length is fractional: a phase accumulator advances by 1 / hold per sample and a new input is captured
+ * each time it wraps, so sweeping the drive moves the effective rate smoothly instead of by whole samples.
+ */
+template <typename SampleType>
+class Decimator {
+public:
+    using Scalar = ScalarOf<SampleType>;
+
+    // The drive is mapped in dB from 0 (no reduction) to max_drive_db (4 bits, hold of 40 samples)
+    explicit Decimator(double max_drive_db) : mMaxDriveDb(max_drive_db) {}
+
+    void reset() {
+        mPhase = 1.0;
+        mHold = SampleType(0);
+    }
+
+    // Process a buffer in-place, with the linear drive of each sample
+    void processBuffer(SampleType* samples, const Scalar* drive, std::size_t count) {
+        for (std::size_t i = 0; i < count; ++i) {
+            if (drive[i] != mDrive) {
+                setDrive(drive[i]);
+            }
+            mPhase += mPhaseIncrement;
+            if (mPhase >= 1.0) {
+                mPhase -= 1.0;
+                // Quantize a clipped version of the signal to avoid explosive outputs
+                const Scalar levels = mLevels;
+                const Scalar inv_levels = mInvLevels;
+                mHold = map(samples[i], [levels, inv_levels](Scalar x) {
+                    return std::round(std::clamp(x, Scalar(-1), Scalar(1)) * levels) * inv_levels;
+                });
+            }
+            samples[i] = mHold;
+        }
+    }
+
+    [[nodiscard]] bool isQuiet(Scalar threshold) const { return maxAbs(mHold) < threshold; }
+
+private:
+    void setDrive(Scalar drive) {
+        mDrive = drive;
+        // Map drive (in dB) to a 0..1 control for bit depth and rate reduction
+        const double drive_norm = std::clamp(utils::linearToDB(drive) / mMaxDriveDb, 0.0, 1.0);
+
+        // Bit depth: from 16 bits (low drive) down to 4 bits (high drive)
+        const int bits = std::clamp(4 + static_cast<int>(std::round((1.0 - drive_norm) * 12.0)), 1, 24);
+        mLevels = static_cast<Scalar>((1 << bits) - 1);
+        mInvLevels = Scalar(1) / mLevels;
+
+        // Sample-rate reduction: hold for 1 (no SRR) up to 40 samples at max drive
+        mPhaseIncrement = 1.0 / (1.0 + drive_norm * 39.0);
+    }
+
+    double mMaxDriveDb;
+
+    // Drive the quantiser and hold length were computed for, a drive of 0 never happens and forces the first computation.
+    Scalar mDrive = 0;
+    Scalar mLevels = 1;
+    Scalar mInvLevels = 1;
+    double mPhaseIncrement = 1.0;
+
+    // Starts wrapped so that the first sample is captured
+    double mPhase = 1.0;
+    SampleType mHold = 0;
+};
+
+} // namespace stfefane::dsp
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "Simd.h"
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace stfefane::dsp {
+
+/**
+ * Delays a signal by a whole number of samples with a ring buffer.
+ * The buffer is allocated by setDelay, which must not be called while processing.
+ */
+template <typename SampleType>
+class DelayLine {
+public:
+    void setDelay(uint32_t delay) {
+        mBuffer.assign(delay, SampleType(0));
+        mPosition = 0;
+    }
+
+    [[nodiscard]] uint32_t getDelay() const { return static_cast<uint32_t>(mBuffer.size()); }
+
+    [[nodiscard]] bool isQuiet(ScalarOf<SampleType> threshold) const {
+        return std::all_of(mBuffer.begin(), mBuffer.end(), [threshold](const SampleType& s) { return maxAbs(s) < threshold; });
+    }
+
+    void reset() {
+        std::fill(mBuffer.begin(), mBuffer.end(), SampleType(0));
+        mPosition = 0;
+    }
+
+    // Process a buffer in-place
+    void processBuffer(SampleType* samples, std::size_t count) {
+        if (mBuffer.empty()) {
+            return;
+        }
+        for (std::size_t i = 0; i < count; ++i) {
+            const SampleType delayed = mBuffer[mPosition];
+            mBuffer[mPosition] = samples[i];
+            samples[i] = delayed;
+            if (++mPosition == mBuffer.size()) {
+                mPosition = 0;
+            }
+        }
+    }
+
+private:
+    std::vector<SampleType> mBuffer;
+    std::size_t mPosition = 0;
+};
+
+} // namespace stfefane::dsp
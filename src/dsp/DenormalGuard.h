@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdint>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <immintrin.h>
+#define STFEFANE_DENORMALS_SSE 1
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+#define STFEFANE_DENORMALS_ARM64 1
+#endif
+
+namespace stfefane::dsp {
+
+/**
+ * Enables flush-to-zero and denormals-are-zero on the current thread for its lifetime,
+ * and restores the previous floating point mode when leaving the scope.
+ * Denormal numbers show up in the decaying states of the recursive filters and are very slow to compute,
+ * with these modes they are replaced by zero in hardware so the DSP code doesn't need to check for them.
+ */
+class DenormalGuard {
+public:
+    DenormalGuard() {
+#if STFEFANE_DENORMALS_SSE
+        mPreviousMode = _mm_getcsr();
+        _mm_setcsr(mPreviousMode | kFlushToZero | kDenormalsAreZero);
+#elif STFEFANE_DENORMALS_ARM64
+        mPreviousMode = getFpcr();
+        setFpcr(mPreviousMode | kFlushToZero);
+#endif
+    }
+
+    ~DenormalGuard() {
+#if STFEFANE_DENORMALS_SSE
+        _mm_setcsr(mPreviousMode);
+#elif STFEFANE_DENORMALS_ARM64
+        setFpcr(mPreviousMode);
+#endif
+    }
+
+    DenormalGuard(const DenormalGuard&) = delete;
+    DenormalGuard& operator=(const DenormalGuard&) = delete;
+
+private:
+#if STFEFANE_DENORMALS_SSE
+    // MXCSR bits
+    static constexpr uint32_t kFlushToZero = 0x8000;
+    static constexpr uint32_t kDenormalsAreZero = 0x0040;
+
+    uint32_t mPreviousMode = 0;
+#elif STFEFANE_DENORMALS_ARM64
+    // FPCR FZ bit, which also treats denormal inputs as zero
+    static constexpr uint64_t kFlushToZero = uint64_t(1) << 24;
+
+    static uint64_t getFpcr() {
+        uint64_t fpcr = 0;
+#if defined(_MSC_VER) && !defined(__clang__)
+        fpcr = _ReadStatusReg(ARM64_FPCR);
+#else
+        asm volatile("mrs %0, fpcr" : "=r"(fpcr));
+#endif
+        return fpcr;
+    }
+
+    static void setFpcr(uint64_t fpcr) {
+#if defined(_MSC_VER) && !defined(__clang__)
+        _WriteStatusReg(ARM64_FPCR, fpcr);
+#else
+        asm volatile("msr fpcr, %0" : : "r"(fpcr));
+#endif
+    }
+
+    uint64_t mPreviousMode = 0;
+#endif
+};
+
+} // namespace stfefane::dsp
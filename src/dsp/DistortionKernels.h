@@ -0,0 +1,130 @@
+#pragma once
+
+#include "Adaa.h"
+#include "FastMath.h"
+#include <algorithm>
+#include <cmath>
+
+namespace stfefane::dsp::kernels {
+
+/**
+ * Memoryless curves of the distortion types, one policy class per type.
+ * process() shapes one sample with the drive and asymmetry of that sample. It is inlined in the block loops of
+ * MultiDisto, which are instantiated once per kernel. Kernels with closed form antiderivatives name them as Curve,
+ * which enables their ADAA version.
+ */
+
+template <typename SampleType>
+struct CubicSaturation {
+    using Curve = adaa::CubicCurve;
+
+    [[nodiscard]] static SampleType process(SampleType input, SampleType drive, SampleType asymmetry) {
+        const SampleType x = input * drive;
+        if (std::abs(x) < SampleType(2) / SampleType(3)) {
+            return x * (SampleType(1) + asymmetry * x);
+        }
+        const SampleType sign = (x > SampleType(0)) ? SampleType(1) : SampleType(-1);
+        const SampleType d = SampleType(2) - SampleType(3) * std::abs(x);
+        return sign * (SampleType(1) - d * d / SampleType(3));
+    }
+};
+
+template <typename SampleType>
+struct TubeSaturation {
+    using Curve = adaa::TubeCurve;
+
+    [[nodiscard]] static SampleType process(SampleType input, SampleType drive, SampleType asymmetry) {
+        // Normalize tanh drive to avoid level jumps: y = tanh(g*x) / tanh(g)
+        const SampleType g = std::max(SampleType(1e-6), SampleType(0.7) * (SampleType(1) + asymmetry));
+        const SampleType x = input * drive;
+        const SampleType y = fastmath::tanhRational(g * x);
+        const SampleType norm = fastmath::tanhRational(g);
+        return (norm > SampleType(0) ? y / norm : y);
+    }
+};
+
+template <typename SampleType>
+struct AsymmetricClip {
+    using Curve = adaa::AsymmetricClipCurve;
+
+    [[nodiscard]] static SampleType process(SampleType input, SampleType drive, SampleType asymmetry) {
+        const SampleType x = input * drive;
+        const SampleType posThresh = SampleType(0.7) + asymmetry * SampleType(0.3);
+        const SampleType negThresh = SampleType(-0.7) - asymmetry * SampleType(0.3);
+
+        if (x > posThresh) {
+            return posThresh + (x - posThresh) * SampleType(0.1);
+        }
+        if (x < negThresh) {
+            return negThresh + (x - negThresh) * SampleType(0.1);
+        }
+        return x;
+    }
+};
+
+template <typename SampleType>
+struct Foldback {
+    [[nodiscard]] static SampleType process(SampleType input, SampleType drive, [[maybe_unused]] SampleType asymmetry) {
+        const SampleType x = input * drive;
+        constexpr SampleType threshold = 1;
+
+        // Modulo-based foldback into [-threshold, threshold]
+        const SampleType ax = std::abs(x);
+        SampleType y = std::fmod(ax, SampleType(2) * threshold);
+        if (y > threshold) {
+            y = SampleType(2) * threshold - y;
+        }
+        y = std::copysign(y, x);
+
+        return y * SampleType(0.7); // Scale down to prevent excessive levels
+    }
+};
+
+template <typename SampleType>
+struct WaveShaper {
+    using Curve = adaa::WaveShaperCurve;
+
+    [[nodiscard]] static SampleType process(SampleType input, SampleType drive, [[maybe_unused]] SampleType asymmetry) {
+        const SampleType x = input * drive;
+        // Sigmoid-based waveshaping
+        const SampleType k = SampleType(2) * drive;
+        return x * (SampleType(1) + k) / (SampleType(1) + k * std::abs(x));
+    }
+};
+
+template <typename SampleType>
+struct TubeScreamer {
+    using Curve = adaa::TubeScreamerCurve;
+
+    [[nodiscard]] static SampleType process(SampleType input, SampleType drive, [[maybe_unused]] SampleType asymmetry) {
+        // Tube Screamer-inspired soft clipping
+        SampleType x = input * drive * SampleType(2);
+        const SampleType sign = (x >= SampleType(0)) ? SampleType(1) : SampleType(-1);
+        x = std::abs(x);
+
+        if (x < SampleType(1) / SampleType(3)) {
+            return sign * SampleType(2) * x;
+        } else if (x < SampleType(2) / SampleType(3)) {
+            const SampleType d = SampleType(2) - SampleType(3) * x;
+            return sign * (SampleType(3) - d * d) / SampleType(3);
+        } else {
+            return sign;
+        }
+    }
+};
+
+template <typename SampleType>
+struct FuzzFace {
+    [[nodiscard]] static SampleType process(SampleType input, SampleType drive, SampleType asymmetry) {
+        // Fuzz Face-inspired germanium transistor distortion
+        SampleType x = input * drive * SampleType(1.5);
+        const SampleType sign = (x >= SampleType(0)) ? SampleType(1) : SampleType(-1);
+        x = std::abs(x);
+
+        // Asymmetric germanium-like curve, only the one of the input polarity is needed
+        const SampleType k = sign > SampleType(0) ? SampleType(2) + asymmetry : SampleType(2) - asymmetry;
+        return sign * (SampleType(1) - fastmath::exp(-x * k)) * SampleType(0.8);
+    }
+};
+
+} // namespace stfefane::dsp::kernels
@@ -0,0 +1,137 @@
+#pragma once
+
+#include "Simd.h"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+namespace stfefane::dsp::fastmath {
+
+/**
+ * Branch-free approximations of exp and tanh for the shaping stage and the safety limiter, and of tan for the
+ * filter prewarping.
+ * They only use arithmetic, min/max and bit casts, so the buffer loops vectorise, unlike the libm calls.
+ * The errors are measured against libm in double, the float versions add the float rounding on top.
+ * These are meant for per sample computations, not for the setup code which keeps using the exact functions.
+ */
+
+// Relative error < 7.5e-8 in double and < 3e-7 in float, over the whole clamped input range: [-708.4, 709.1] in
+// double and [-87.3, 88] in float, beyond which the result saturates.
+// exp(x) = 2^k * 2^f with k the integer nearest to x / ln(2), and 2^f on [-0.5, 0.5] from a degree 5 minimax polynomial.
+// The remainder x - k * ln(2) is computed with ln(2) split in two constants (Cody-Waite), the first one exact when
+// multiplied by any k. Taking f = x / ln(2) - k instead would lose the low bits of f to the rounding of x / ln(2).
+// The input is clamped so that the result stays a normal number.
+template <typename T>
+[[nodiscard]] inline T exp(T x) {
+    static_assert(std::is_floating_point_v<T>);
+    using Int = std::conditional_t<std::is_same_v<T, float>, int32_t, int64_t>;
+    constexpr int kMantissaBits = std::numeric_limits<T>::digits - 1;
+    constexpr Int kExponentBias = std::numeric_limits<T>::max_exponent - 1;
+    // Adding and subtracting 1.5 * 2^mantissa rounds to the nearest integer
+    constexpr T kRoundingMagic = T(1.5) * static_cast<T>(Int(1) << kMantissaBits);
+    constexpr T kLog2e = T(1.4426950408889634);
+    // ln(2) with its last 8 bits cleared, so k * kLn2High is exact, and the rest of it
+    constexpr T kLn2High = T(0.693145751953125);
+    constexpr T kLn2Low = T(1.4286068203094172e-06);
+
+    x = std::clamp(x, T(1 - kExponentBias) / kLog2e, T(kExponentBias) / kLog2e);
+    const T k = (x * kLog2e + kRoundingMagic) - kRoundingMagic;
+    const T f = ((x - k * kLn2High) - k * kLn2Low) * kLog2e;
+    const T p = T(1.0000000716546822)
+              + f * (T(0.693146967064733)
+              + f * (T(0.2402211972384865)
+              + f * (T(0.05550713273543075) + f * (T(0.009675541334209831) + f * T(0.0013276471979286704)))));
+    const T scale = std::bit_cast<T>(static_cast<Int>(static_cast<Int>(k) + kExponentBias) << kMantissaBits);
+    return p * scale;
+}
+
+// Absolute error < 1.5e-7, as tanh(x) = (e^2x - 1) / (e^2x + 1) with the fast exp.
+template <typename T>
+[[nodiscard]] inline T tanhExp(T x) {
+    const T e = exp(T(2) * std::clamp(x, T(-10), T(10)));
+    return (e - T(1)) / (e + T(1));
+}
+
+// Absolute error < 7e-6, reached at the clamping point.
+// [9/8] Pade approximant from Lambert's continued fraction, it increases monotonically up to 1 at |x| = 6.297.
+template <typename T>
+[[nodiscard]] inline T tanhRational(T x) {
+    x = std::clamp(x, T(-6.297019181706205), T(6.297019181706205));
+    const T x2 = x * x;
+    const T num = x * (T(34459425) + x2 * (T(4729725) + x2 * (T(135135) + x2 * (T(990) + x2))));
+    const T den = T(34459425) + x2 * (T(16216200) + x2 * (T(945945) + x2 * (T(13860) + x2 * T(45))));
+    return num / den;
+}
+
+// Relative error < 1.5e-7 for |x| <= 0.99 * pi / 2, which covers the prewarping of frequencies up to 0.99 * Nyquist.
+// [7/6] Pade approximant from Lambert's continued fraction, its pole sits right above pi / 2 like the one of tan.
+template <typename T>
+[[nodiscard]] inline T tan(T x) {
+    const T x2 = x * x;
+    const T num = x * (T(135135) - x2 * (T(17325) - x2 * (T(378) - x2)));
+    const T den = T(135135) - x2 * (T(62370) - x2 * (T(3150) - x2 * T(28)));
+    return num / den;
+}
+
+namespace detail {
+
+// exp for the table generation, exp(x) = exp(x / 2^8)^(2^8) with a Taylor series for the reduced argument
+constexpr double constexprExp(double x) {
+    const double y = x / 256.0;
+    double sum = 1.0;
+    double term = 1.0;
+    for (int k = 1; k <= 12; ++k) {
+        term *= y / k;
+        sum += term;
+    }
+    for (int k = 0; k < 8; ++k) {
+        sum *= sum;
+    }
+    return sum;
+}
+
+static constexpr double kTanhTableRange = 8.0;
+static constexpr std::size_t kTanhTableSize = 1024;
+
+template <typename T>
+constexpr std::array<T, kTanhTableSize + 2> makeTanhTable() {
+    // One extra point past the range so the interpolation at the last index doesn't need a check
+    std::array<T, kTanhTableSize + 2> table = {};
+    for (std::size_t i = 0; i < table.size(); ++i) {
+        const double x = kTanhTableRange * static_cast<double>(i) / kTanhTableSize;
+        table[i] = static_cast<T>(1.0 - 2.0 / (constexprExp(2.0 * x) + 1.0));
+    }
+    return table;
+}
+
+template <typename T>
+inline constexpr auto kTanhTable = makeTanhTable<T>();
+
+} // namespace detail
+
+// Absolute error < 6e-6, from the linear interpolation between points spaced by 1/128 (h^2 / 8 * max |tanh''|).
+// Table generated at compile time over [0, 8], the odd symmetry covers negative inputs.
+template <typename T>
+[[nodiscard]] inline T tanhLut(T x) {
+    constexpr T kScale = static_cast<T>(detail::kTanhTableSize / detail::kTanhTableRange);
+    const T position = std::min(std::fabs(x) * kScale, static_cast<T>(detail::kTanhTableSize));
+    const auto index = static_cast<std::size_t>(position);
+    const T frac = position - static_cast<T>(index);
+    const auto& table = detail::kTanhTable<T>;
+    return std::copysign(table[index] + frac * (table[index + 1] - table[index]), x);
+}
+
+// Soft clipping of a whole buffer of samples or lane groups, with the rational tanh
+template <typename T>
+void tanhBuffer(T* samples, std::size_t count) {
+    for (std::size_t i = 0; i < count; ++i) {
+        samples[i] = map(samples[i], [](ScalarOf<T> x) { return tanhRational(x); });
+    }
+}
+
+} // namespace stfefane::dsp::fastmath
@@ -0,0 +1,224 @@
+#pragma once
+
+#include "BiquadFilter.h"
+#include "SmoothedValue.h"
+#include "SvfFilter.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace stfefane::dsp {
+
+/**
+ * Settings of a filter smoothed on the audio thread, turned into per sample coefficients shared by all the channels.
+ * The setters only move targets. The coefficients are designed at most once every kControlInterval samples from the
+ * smoothed settings, and linearly interpolated in between. Many parameter changes in a row cost a single design
+ * whatever their number, and automation doesn't click.
+ * The designs are memoised in a small cache, so settings coming back to recent values don't redesign.
+ * A change of type or topology can't be interpolated, the coefficients jump at the start of the next block.
+ */
+template <typename SampleType>
+class FilterRamp {
+public:
+    static constexpr uint32_t kControlInterval = 32;
+
+    FilterRamp(FilterType type, double freq, uint32_t max_block_size) : mType(type) {
+        mLogFreq = static_cast<SampleType>(std::log2(freq));
+        mQ = SampleType(0.707);
+        mGainDb = SampleType(0);
+        setMaxBlockSize(max_block_size);
+    }
+
+    // Jumps to the current settings, must not be called while processing.
+    void setSampleRate(double sampleRate) {
+        // Builds the trigonometry table of the control rate designs here rather than on the first processed block.
+        static_cast<void>(LogFrequencyTrigTable::instance());
+        mSampleRate = sampleRate;
+        for (auto* value : {&mLogFreq, &mQ, &mGainDb}) {
+            value->setup(sampleRate, kSmoothingMs);
+            value->snap();
+        }
+        mLogFreqModulation.snap();
+        mCache = {};
+        mDesignedType = mType;
+        mDesignedTopology = mTopology;
+        mCurrent = design();
+        mTarget = mCurrent;
+        mStep = {};
+        mRamping = false;
+        mSamplesToControl = 0;
+        mConstantLength = 0;
+    }
+
+    // Allocates the coefficient ramps for blocks of up to max_block_size samples, must not be called while processing.
+    void setMaxBlockSize(uint32_t max_block_size) {
+        for (auto& ramp : mRamps) {
+            ramp.assign(max_block_size, SampleType(0));
+        }
+        mConstantLength = 0;
+    }
+
+    void setType(FilterType type) { mType = type; }
+    void setTopology(FilterTopology topology) { mTopology = topology; }
+    void setFreq(double freq) { mLogFreq = static_cast<SampleType>(std::log2(std::max(freq, 1.0))); }
+    void setQ(double q) { mQ = static_cast<SampleType>(q); }
+    void setGainDb(double gain_db) { mGainDb = static_cast<SampleType>(gain_db); }
+    // Host modulation of the frequency in octaves, reached by the end of the next rendered block rather than smoothed
+    void setFreqModulation(double octaves) { mLogFreqModulation = static_cast<SampleType>(octaves); }
+
+    [[nodiscard]] FilterType getType() const { return mType; }
+    // Topology of the coefficients rendered by the last render call
+    [[nodiscard]] FilterTopology getTopology() const { return mDesignedTopology; }
+
+    // Render the coefficients of the next n samples (up to the max block size)
+    void render(uint32_t n) {
+        mLogFreqModulation.rampOver(n);
+        if (isSettled()) {
+            // Coefficients already in place from a previous block, pick the next change up right away.
+            if (mConstantLength < n) {
+                for (std::size_t c = 0; c < mRamps.size(); ++c) {
+                    std::fill_n(mRamps[c].begin(), n, static_cast<SampleType>(mCurrent[c]));
+                }
+                mConstantLength = n;
+            }
+            mSamplesToControl = 0;
+            return;
+        }
+
+        mConstantLength = 0;
+        // A new type or topology is picked up right away, so the whole block is rendered for a single one.
+        if (mType != mDesignedType || mTopology != mDesignedTopology) {
+            mSamplesToControl = 0;
+        }
+        for (uint32_t i = 0; i < n;) {
+            if (mSamplesToControl == 0) {
+                controlTick();
+            }
+            const uint32_t length = std::min(n - i, mSamplesToControl);
+            for (std::size_t c = 0; c < mRamps.size(); ++c) {
+                const double start = mCurrent[c];
+                const double step = mStep[c];
+                SampleType* ramp = mRamps[c].data() + i;
+                for (uint32_t j = 0; j < length; ++j) {
+                    ramp[j] = static_cast<SampleType>(start + step * static_cast<double>(j + 1));
+                }
+                mCurrent[c] = start + step * static_cast<double>(length);
+            }
+            mSamplesToControl -= length;
+            i += length;
+        }
+    }
+
+    // Coefficients rendered by the last render call, starting at offset. They are {b0, b1, b2, a1, a2} for the
+    // biquads and {g, k, m0, m1, m2} for the state variable filters.
+    [[nodiscard]] CoefficientRamp<SampleType> coefficients(uint32_t offset) const {
+        return {mRamps[0].data() + offset, mRamps[1].data() + offset, mRamps[2].data() + offset,
+                mRamps[3].data() + offset, mRamps[4].data() + offset};
+    }
+
+    // Number of samples for the impulse response to decay by the given ratio, once the settings are reached.
+    // Both topologies have the response of the RBJ biquad.
+    [[nodiscard]] double decaySamples(double ratio) const {
+        return designBiquad(mType, mSampleRate, std::exp2(mLogFreq.mTargetValue + mLogFreqModulation.mTargetValue),
+                            mQ.mTargetValue, mGainDb.mTargetValue)
+            .decaySamples(ratio);
+    }
+
+private:
+    using Coefficients = std::array<double, 5>;
+
+    static constexpr double kSmoothingMs = 20.;
+    static constexpr std::size_t kCacheSize = 4;
+
+    struct CacheEntry {
+        bool valid = false;
+        FilterTopology topology = FilterTopology::Biquad;
+        FilterType type = FilterType::None;
+        SampleType log_freq = 0;
+        SampleType q = 0;
+        SampleType gain_db = 0;
+        Coefficients coefficients = {};
+    };
+
+    [[nodiscard]] bool isSettled() const {
+        return !mRamping && mType == mDesignedType && mTopology == mDesignedTopology && mLogFreq.isSettled()
+            && mLogFreqModulation.isSettled() && mQ.isSettled() && mGainDb.isSettled();
+    }
+
+    // Moves the settings to the next control point, and sets the interpolation towards their design.
+    void controlTick() {
+        mSamplesToControl = kControlInterval;
+        // The last segment ended on its target, drop the rounding of the increments.
+        mCurrent = mTarget;
+        for (auto* value : {&mLogFreq, &mLogFreqModulation, &mQ, &mGainDb}) {
+            value->skip(kControlInterval);
+        }
+
+        mTarget = design();
+        if (mType != mDesignedType || mTopology != mDesignedTopology) {
+            mDesignedType = mType;
+            mDesignedTopology = mTopology;
+            mCurrent = mTarget;
+        }
+        mRamping = mTarget != mCurrent;
+        for (std::size_t c = 0; c < mStep.size(); ++c) {
+            mStep[c] = (mTarget[c] - mCurrent[c]) / kControlInterval;
+        }
+    }
+
+    // Coefficients of the current smoothed settings, from the cache when possible
+    [[nodiscard]] Coefficients design() {
+        const SampleType log_freq = mLogFreq + mLogFreqModulation;
+        const SampleType q = mQ;
+        const SampleType gain_db = mGainDb;
+        for (const auto& entry : mCache) {
+            if (entry.valid && entry.topology == mTopology && entry.type == mType && entry.log_freq == log_freq
+                && entry.q == q && entry.gain_db == gain_db) {
+                return entry.coefficients;
+            }
+        }
+
+        const double freq = std::exp2(static_cast<double>(log_freq));
+        Coefficients coefficients;
+        if (mTopology == FilterTopology::StateVariable) {
+            const auto c = designSvf(mType, mSampleRate, freq, q, gain_db);
+            coefficients = {c.g, c.k, c.m0, c.m1, c.m2};
+        } else {
+            const auto c = designBiquadFast(mType, mSampleRate, freq, q, gain_db);
+            coefficients = {c.b0, c.b1, c.b2, c.a1, c.a2};
+        }
+        mCache[mNextCacheEntry] = {true, mTopology, mType, log_freq, q, gain_db, coefficients};
+        mNextCacheEntry = (mNextCacheEntry + 1) % kCacheSize;
+        return coefficients;
+    }
+
+    double mSampleRate = 44100.0;
+
+    // Settings targets, the frequency being smoothed in octaves
+    FilterType mType;
+    FilterTopology mTopology = FilterTopology::Biquad;
+    SmoothedValue<SampleType> mLogFreq;
+    SmoothedValue<SampleType> mLogFreqModulation;
+    SmoothedValue<SampleType> mQ;
+    SmoothedValue<SampleType> mGainDb;
+
+    // Interpolation from the coefficients of the last control point to the ones of the next
+    FilterType mDesignedType = FilterType::None;
+    FilterTopology mDesignedTopology = FilterTopology::Biquad;
+    Coefficients mCurrent = {};
+    Coefficients mTarget = {};
+    Coefficients mStep = {};
+    bool mRamping = false;
+    uint32_t mSamplesToControl = 0;
+
+    std::array<CacheEntry, kCacheSize> mCache = {};
+    std::size_t mNextCacheEntry = 0;
+
+    // Coefficients of each sample of the block, the first mConstantLength ones holding mCurrent
+    std::array<std::vector<SampleType>, 5> mRamps;
+    uint32_t mConstantLength = 0;
+};
+
+} // namespace stfefane::dsp
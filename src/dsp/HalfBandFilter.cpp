@@ -0,0 +1,245 @@
+#include "HalfBandFilter.h"
+
+#include "utils/Utils.h"
+#include <algorithm>
+#include <cmath>
+
+namespace stfefane::dsp {
+
+// Zeroth order modified Bessel function of the first kind, for the Kaiser window
+static double besselI0(double x) {
+    double sum = 1.0;
+    double term = 1.0;
+    for (int k = 1; k < 50 && term > 1e-12 * sum; ++k) {
+        const double half_x_over_k = x / (2.0 * k);
+        term *= half_x_over_k * half_x_over_k;
+        sum += term;
+    }
+    return sum;
+}
+
+std::vector<double> designHalfBand(uint32_t half_length, double kaiser_beta) {
+    const double center = 2.0 * half_length - 1.0;
+    std::vector<double> kernel(half_length);
+    double sum = 0.0;
+    for (uint32_t j = 0; j < half_length; ++j) {
+        const double distance = center - 2.0 * j;
+        const double x = utils::kPI_64 * distance / 2.0;
+        const double ratio = distance / center;
+        const double window = besselI0(kaiser_beta * std::sqrt(1.0 - ratio * ratio)) / besselI0(kaiser_beta);
+        kernel[j] = std::sin(x) / x * window;
+        sum += kernel[j];
+    }
+    // Each coefficient applies to a pair of symmetric samples, they must add up to 1 for unity gain at DC.
+    for (auto& coeff : kernel) {
+        coeff *= 0.5 / sum;
+    }
+    return kernel;
+}
+
+template <typename SampleType>
+void HalfBandStage<SampleType>::setup(const std::vector<double>& kernel, uint32_t max_input) {
+    mHalfLength = static_cast<uint32_t>(kernel.size());
+    mKernel.assign(kernel.begin(), kernel.end());
+
+    const uint32_t history = 2 * mHalfLength - 1;
+    mUpBuffer.assign(history + max_input, SampleType(0));
+    mEvenBuffer.assign(history + max_input, SampleType(0));
+    mOddBuffer.assign(mHalfLength + max_input, SampleType(0));
+}
+
+template <typename SampleType>
+void HalfBandStage<SampleType>::reset() {
+    std::fill(mUpBuffer.begin(), mUpBuffer.end(), SampleType(0));
+    std::fill(mEvenBuffer.begin(), mEvenBuffer.end(), SampleType(0));
+    std::fill(mOddBuffer.begin(), mOddBuffer.end(), SampleType(0));
+}
+
+template <typename SampleType>
+void HalfBandStage<SampleType>::upsample(const SampleType* input, SampleType* output, uint32_t n) {
+    const uint32_t K = mHalfLength;
+    const uint32_t history = 2 * K - 1;
+    std::copy_n(input, n, mUpBuffer.data() + history);
+
+    const Scalar* kernel = mKernel.data();
+    for (uint32_t i = 0; i < n; ++i) {
+        // Window of the 2K last input samples, the kernel being symmetric the pairs share a coefficient.
+        const SampleType* w = mUpBuffer.data() + i;
+        SampleType acc = 0;
+        for (uint32_t j = 0; j < K; ++j) {
+            acc += kernel[j] * (w[j] + w[history - j]);
+        }
+        output[2 * i] = acc;
+        // The other phase only hits the center tap
+        output[2 * i + 1] = w[K];
+    }
+
+    std::copy_n(mUpBuffer.data() + n, history, mUpBuffer.data());
+}
+
+template <typename SampleType>
+void HalfBandStage<SampleType>::downsample(const SampleType* input, SampleType* output, uint32_t n) {
+    const uint32_t K = mHalfLength;
+    const uint32_t history = 2 * K - 1;
+    SampleType* even = mEvenBuffer.data() + history;
+    SampleType* odd = mOddBuffer.data() + K;
+    for (uint32_t i = 0; i < n; ++i) {
+        even[i] = input[2 * i];
+        odd[i] = input[2 * i + 1];
+    }
+
+    const Scalar* kernel = mKernel.data();
+    for (uint32_t i = 0; i < n; ++i) {
+        const SampleType* w = mEvenBuffer.data() + i;
+        SampleType acc = 0;
+        for (uint32_t j = 0; j < K; ++j) {
+            acc += kernel[j] * (w[j] + w[history - j]);
+        }
+        output[i] = Scalar(0.5) * (acc + mOddBuffer[i]);
+    }
+
+    std::copy_n(mEvenBuffer.data() + n, history, mEvenBuffer.data());
+    std::copy_n(mOddBuffer.data() + n, K, mOddBuffer.data());
+}
+
+template <typename SampleType>
+bool HalfBandStage<SampleType>::isQuiet(Scalar threshold) const {
+    const auto quiet = [threshold](const SampleType& s) { return maxAbs(s) < threshold; };
+    const uint32_t history = 2 * mHalfLength - 1;
+    return std::all_of(mUpBuffer.begin(), mUpBuffer.begin() + history, quiet)
+        && std::all_of(mEvenBuffer.begin(), mEvenBuffer.begin() + history, quiet)
+        && std::all_of(mOddBuffer.begin(), mOddBuffer.begin() + mHalfLength, quiet);
+}
+
+// Elliptic modulus and nome of the prototype filter for a transition bandwidth
+static void allpassTransitionParameters(double transition_bandwidth, double& k, double& q) {
+    k = std::tan((1.0 - transition_bandwidth * 2.0) * utils::kPI_64 / 4.0);
+    k *= k;
+    const double kk_sqrt = std::pow(1.0 - k * k, 0.25);
+    const double e = 0.5 * (1.0 - kk_sqrt) / (1.0 + kk_sqrt);
+    const double e4 = e * e * e * e;
+    q = e * (1.0 + e4 * (2.0 + e4 * (15.0 + 150.0 * e4)));
+}
+
+std::vector<double> designHalfBandAllpass(double attenuation_db, double transition_bandwidth) {
+    double k = 0.0;
+    double q = 0.0;
+    allpassTransitionParameters(transition_bandwidth, k, q);
+
+    // Lowest odd order reaching the attenuation, the filter has (order - 1) / 2 coefficients.
+    const double attenuation = std::pow(10.0, -attenuation_db / 10.0);
+    const double a = attenuation / (1.0 - attenuation);
+    auto order = static_cast<uint32_t>(std::ceil(std::log(a * a / 16.0) / std::log(q)));
+    order = std::max(order | 1u, 3u);
+    const auto nb_coefficients = std::min((order - 1) / 2, HalfBandAllpassStage<double>::kMaxCoefficients);
+
+    // Theta functions series, summed until the terms vanish
+    std::vector<double> coefficients(nb_coefficients);
+    for (uint32_t index = 0; index < nb_coefficients; ++index) {
+        const double c = utils::kPI_64 * (index + 1.0) / order;
+        double num = 0.0;
+        double term = 0.0;
+        double sign = 1.0;
+        for (int i = 0; i == 0 || std::fabs(term) > 1e-100; ++i, sign = -sign) {
+            term = sign * std::pow(q, i * (i + 1)) * std::sin((2 * i + 1) * c);
+            num += term;
+        }
+        double den = 0.0;
+        sign = -1.0;
+        for (int i = 1; i == 1 || std::fabs(term) > 1e-100; ++i, sign = -sign) {
+            term = sign * std::pow(q, i * i) * std::cos(2 * i * c);
+            den += term;
+        }
+        const double ww = num * std::pow(q, 0.25) / (den + 0.5);
+        const double ww2 = ww * ww;
+        const double x = std::sqrt((1.0 - ww2 * k) * (1.0 - ww2 / k)) / (1.0 + ww2);
+        coefficients[index] = (1.0 - x) / (1.0 + x);
+    }
+    return coefficients;
+}
+
+template <typename SampleType>
+void HalfBandAllpassStage<SampleType>::setup(const std::vector<double>& coefficients) {
+    mNbCoefficients = static_cast<uint32_t>(std::min<std::size_t>(coefficients.size(), kMaxCoefficients));
+    std::copy_n(coefficients.begin(), mNbCoefficients, mCoefficients.begin());
+    reset();
+}
+
+template <typename SampleType>
+void HalfBandAllpassStage<SampleType>::reset() {
+    mUpStates = {};
+    mDownStates = {};
+}
+
+template <typename SampleType>
+void HalfBandAllpassStage<SampleType>::processChains(AllpassStates& states, SampleType& even, SampleType& odd) const {
+    for (uint32_t k = 0; k < mNbCoefficients; ++k) {
+        SampleType& x = k % 2 == 0 ? even : odd;
+        const SampleType y = mCoefficients[k] * (x - states.y1[k]) + states.x1[k];
+        states.x1[k] = x;
+        states.y1[k] = y;
+        x = y;
+    }
+}
+
+template <typename SampleType>
+void HalfBandAllpassStage<SampleType>::upsample(const SampleType* input, SampleType* output, uint32_t n) {
+    for (uint32_t i = 0; i < n; ++i) {
+        SampleType even = input[i];
+        SampleType odd = input[i];
+        processChains(mUpStates, even, odd);
+        output[2 * i] = even;
+        output[2 * i + 1] = odd;
+    }
+}
+
+template <typename SampleType>
+void HalfBandAllpassStage<SampleType>::downsample(const SampleType* input, SampleType* output, uint32_t n) {
+    for (uint32_t i = 0; i < n; ++i) {
+        SampleType even = input[2 * i + 1];
+        SampleType odd = input[2 * i];
+        processChains(mDownStates, even, odd);
+        output[i] = Scalar(0.5) * (even + odd);
+    }
+}
+
+template <typename SampleType>
+bool HalfBandAllpassStage<SampleType>::isQuiet(Scalar threshold) const {
+    const auto quiet = [threshold](const SampleType& s) { return maxAbs(s) < threshold; };
+    for (const auto* states : {&mUpStates, &mDownStates}) {
+        if (!std::all_of(states->x1.begin(), states->x1.begin() + mNbCoefficients, quiet)
+            || !std::all_of(states->y1.begin(), states->y1.begin() + mNbCoefficients, quiet)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <typename SampleType>
+double HalfBandAllpassStage<SampleType>::latency() const {
+    // A section (a + z^-1) / (1 + a z^-1) delays low frequencies by (1 - a) / (1 + a) samples. Both directions average
+    // the two chains, the half sample offset between them cancelling out over the round trip.
+    double delay = 0.0;
+    for (uint32_t k = 0; k < mNbCoefficients; ++k) {
+        delay += (1.0 - mCoefficients[k]) / (1.0 + mCoefficients[k]);
+    }
+    return delay;
+}
+
+template <typename SampleType>
+double HalfBandAllpassStage<SampleType>::decaySamples(double ratio) const {
+    // The pole of a section sits at -a, in both directions
+    double decay = 0.0;
+    for (uint32_t k = 0; k < mNbCoefficients; ++k) {
+        decay += 2.0 * std::log(ratio) / std::log(static_cast<double>(mCoefficients[k]));
+    }
+    return decay;
+}
+
+// Channel groups processed by MultiDisto
+template class HalfBandStage<Lanes<float, 4>>;
+template class HalfBandStage<Lanes<double, 2>>;
+template class HalfBandAllpassStage<Lanes<float, 4>>;
+template class HalfBandAllpassStage<Lanes<double, 2>>;
+
+} // namespace stfefane::dsp
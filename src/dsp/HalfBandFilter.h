@@ -0,0 +1,97 @@
+#pragma once
+
+#include "Simd.h"
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace stfefane::dsp {
+
+// Linear phase half-band low-pass kernel of 4 * half_length - 1 taps, designed as a Kaiser windowed sinc.
+// In a half-band kernel every other tap is zero and the center one is 0.5, so only the half_length taps at odd
+// distances from the center are returned, from the outermost to the innermost, scaled for a unity interpolation gain.
+[[nodiscard]] std::vector<double> designHalfBand(uint32_t half_length, double kaiser_beta);
+
+/**
+ * One 2x stage of a polyphase oversampler, running a half-band FIR kernel in both directions.
+ * Thanks to the zero taps, upsampling costs half_length multiplies per input sample (the other phase is a plain copy
+ * of the delayed input), and downsampling half_length multiplies per output sample.
+ * Works on blocks, the inner loops run over Frame lanes so all the channels of a group are filtered together.
+ */
+template <typename SampleType>
+class HalfBandStage {
+public:
+    using Scalar = ScalarOf<SampleType>;
+
+    // Allocates the histories for blocks of up to max_input samples at the input rate of the stage.
+    void setup(const std::vector<double>& kernel, uint32_t max_input);
+    void reset();
+
+    // n input samples to 2n output samples
+    void upsample(const SampleType* input, SampleType* output, uint32_t n);
+    // 2n input samples to n output samples
+    void downsample(const SampleType* input, SampleType* output, uint32_t n);
+
+    [[nodiscard]] bool isQuiet(Scalar threshold) const;
+    // Delay of the up/down round trip, in samples at the input rate of the stage
+    [[nodiscard]] uint32_t latency() const { return 2 * mHalfLength - 1; }
+
+private:
+    uint32_t mHalfLength = 0;
+    std::vector<Scalar> mKernel;
+
+    // Each buffer starts with the history needed by the kernel, followed by the samples of the current block.
+    std::vector<SampleType> mUpBuffer;
+    std::vector<SampleType> mEvenBuffer;
+    std::vector<SampleType> mOddBuffer;
+};
+
+// Coefficients of a polyphase IIR half-band low-pass, made of two parallel chains of first order allpass sections in z^-2
+// (Valenzuela & Constantinides, the design used by HIIR). The order is the lowest one reaching the stopband attenuation
+// in dB for the transition bandwidth, relative to the output sample rate of the stage (the passband ends at 0.25 - tbw).
+// Coefficients are sorted by increasing value, the even ones go to the first chain and the odd ones to the second.
+[[nodiscard]] std::vector<double> designHalfBandAllpass(double attenuation_db, double transition_bandwidth);
+
+/**
+ * One 2x stage of a polyphase oversampler, running an allpass half-band IIR filter in both directions.
+ * The response is close to minimum phase, the delay being a few samples at low frequencies instead of the
+ * half kernel length of the FIR stages, with the same steep stopband. Each allpass section costs a single multiply
+ * per input sample of the stage. The inner loops run over Frame lanes so all the channels of a group are filtered together.
+ */
+template <typename SampleType>
+class HalfBandAllpassStage {
+public:
+    using Scalar = ScalarOf<SampleType>;
+    static constexpr uint32_t kMaxCoefficients = 16;
+
+    void setup(const std::vector<double>& coefficients);
+    void reset();
+
+    // n input samples to 2n output samples
+    void upsample(const SampleType* input, SampleType* output, uint32_t n);
+    // 2n input samples to n output samples
+    void downsample(const SampleType* input, SampleType* output, uint32_t n);
+
+    [[nodiscard]] bool isQuiet(Scalar threshold) const;
+    // Group delay of the up/down round trip at low frequencies, in samples at the input rate of the stage
+    [[nodiscard]] double latency() const;
+    // Number of samples at the input rate of the stage for the round trip to decay by the given ratio
+    [[nodiscard]] double decaySamples(double ratio) const;
+
+private:
+    // Input and output memories of the allpass sections of both chains
+    struct AllpassStates {
+        std::array<SampleType, kMaxCoefficients> x1 = {};
+        std::array<SampleType, kMaxCoefficients> y1 = {};
+    };
+
+    // Runs one sample through each chain, the first one in even and the second one in odd
+    void processChains(AllpassStates& states, SampleType& even, SampleType& odd) const;
+
+    uint32_t mNbCoefficients = 0;
+    std::array<Scalar, kMaxCoefficients> mCoefficients = {};
+    AllpassStates mUpStates;
+    AllpassStates mDownStates;
+};
+
+} // namespace stfefane::dsp
@@ -1,6 +1,7 @@
 #include "MultiDisto.h"
 
-#include "disstortion.h"
+#include "DistortionKernels.h"
+#include "FastMath.h"
 #include "utils/Logger.h"
 #include "utils/Utils.h"
 #include <algorithm>
@@ -8,271 +9,401 @@
 
 namespace stfefane::dsp {
 
-void MultiDisto::initParameterAttachments(const Disstortion& d) {
-    using namespace params;
-    mParameterAttachments.reserve(d.getParameters().count());
-
-    auto add_basic_attachment = [&](clap_id id, SmoothedValue& attached_to) {
-        mParameterAttachments.emplace_back(d.getParameter(id), [&](Parameter* param, double new_val) {
-            attached_to = param->getValueType().denormalizedValue(new_val);
-        });
-    };
-    add_basic_attachment(eAsymmetry, mAsymmetry);
-
-    auto add_dB_attachment = [&]<typename T>(clap_id id, T& attached_to) {
-        mParameterAttachments.emplace_back(d.getParameter(id), [&](Parameter* param, double new_val) {
-            attached_to = utils::dbToLinear(param->getValueType().denormalizedValue(new_val));
-        });
-    };
-    add_dB_attachment(eDrive, mDrive);
-    add_dB_attachment(eInGain, mInputGain);
-    add_dB_attachment(eOutGain, mOutputGain);
-
-    mParameterAttachments.emplace_back(d.getParameter(eMix), [&](Parameter*, double new_val) {
-        mMix = new_val;
-    });
-    mParameterAttachments.emplace_back(d.getParameter(eDriveType), [&](Parameter*, double new_type) {
-        mType = static_cast<dsp::DistortionType>(new_type);
-    });
+template <typename SampleType>
+void MultiDisto<SampleType>::setParameters(const DspParameters& parameters) {
+    if (mParametersVersion == parameters.version) {
+        return;
+    }
+    mParametersVersion = parameters.version;
+
+    mType = parameters.type;
+    mDrive = static_cast<SampleType>(parameters.drive);
+    mInputGain = static_cast<SampleType>(parameters.input_gain);
+    mOutputGain = static_cast<SampleType>(parameters.output_gain);
+    mAsymmetry = static_cast<SampleType>(parameters.asymmetry);
+    mDriveModulation = static_cast<SampleType>(parameters.drive_modulation);
+    mAsymmetryModulation = static_cast<SampleType>(parameters.asymmetry_modulation);
+    mMix = static_cast<SampleType>(parameters.mix);
+
+    // The filter settings only move the targets of the ramps, the coefficients are designed while processing.
+    if (parameters.pre_filter != mPreFilterSettings || parameters.post_filter != mPostFilterSettings) {
+        mTailChanged = true;
+    }
+    mPreFilterSettings = parameters.pre_filter;
+    setFilterSettings(mPreFilterRamp, parameters.pre_filter);
+    mPostFilterSettings = parameters.post_filter;
+    setFilterSettings(mPostFilterRamp, parameters.post_filter);
+    setFilterTopology(parameters.filter_topology);
+}
 
-    mParameterAttachments.emplace_back(d.getParameter(ePreFilterOn), [&](Parameter*, double new_pre) {
-        mPreFilterOn = new_pre > .5;
-    });
-    mParameterAttachments.emplace_back(d.getParameter(ePreFilterType), [&](Parameter*, double new_type) {
-        mPreFilter.setType(static_cast<BiquadFilter::Type>(new_type + 1)); // +1 because we skip None.
-    });
-    mParameterAttachments.emplace_back(d.getParameter(ePreFilterFreq), [&](Parameter* param, double new_freq) {
-        mPreFilter.setFreq(param->getValueType().denormalizedValue(new_freq));
-    });
-    mParameterAttachments.emplace_back(d.getParameter(ePreFilterQ), [&](Parameter* param, double new_q) {
-        mPreFilter.setQ(param->getValueType().denormalizedValue(new_q));
-    });
-    mParameterAttachments.emplace_back(d.getParameter(ePreFilterGain), [&](Parameter* param, double new_gain) {
-        mPreFilter.setGainDb(param->getValueType().denormalizedValue(new_gain));
-    });
+template <typename SampleType>
+void MultiDisto<SampleType>::setFilterSettings(FilterRamp<SampleType>& ramp, const FilterSettings& settings) {
+    ramp.setType(settings.type);
+    ramp.setFreq(settings.freq);
+    ramp.setQ(settings.q);
+    ramp.setGainDb(settings.gain_db);
+    ramp.setFreqModulation(settings.freq_modulation);
+}
 
-    mParameterAttachments.emplace_back(d.getParameter(ePostFilterOn), [&](Parameter*, double new_post) {
-        mPostFilterOn = new_post > .5;
-    });
-    mParameterAttachments.emplace_back(d.getParameter(ePostFilterType), [&](Parameter*, double new_type) {
-        mPostFilter.setType(static_cast<BiquadFilter::Type>(new_type + 1)); // +1 because we skip None.
-    });
-    mParameterAttachments.emplace_back(d.getParameter(ePostFilterFreq), [&](Parameter* param, double new_freq) {
-        mPostFilter.setFreq(param->getValueType().denormalizedValue(new_freq));
-    });
-    mParameterAttachments.emplace_back(d.getParameter(ePostFilterQ), [&](Parameter* param, double new_q) {
-        mPostFilter.setQ(param->getValueType().denormalizedValue(new_q));
-    });
-    mParameterAttachments.emplace_back(d.getParameter(ePostFilterGain), [&](Parameter* param, double new_gain) {
-        mPostFilter.setGainDb(param->getValueType().denormalizedValue(new_gain));
-    });
+template <typename SampleType>
+void MultiDisto<SampleType>::setFilterTopology(FilterTopology topology) {
+    if (topology == mFilterTopology) {
+        return;
+    }
+    mFilterTopology = topology;
+    mPreFilterRamp.setTopology(topology);
+    mPostFilterRamp.setTopology(topology);
+    // The filters that were idle kept a stale state, which would play back and prevent the quiet detection.
+    for (auto& group : mGroups) {
+        group.mPreFilter.reset();
+        group.mPostFilter.reset();
+    }
 }
 
-void MultiDisto::setSampleRate(double samplerate) {
+template <typename SampleType>
+void MultiDisto<SampleType>::setSampleRate(double samplerate) {
     LOG_INFO("dsp", "[MultiDisto::setSampleRate] new_samplerate = {}", samplerate);
     mSampleRate = samplerate;
-    mOversampler.setupAntiAliasing(samplerate);
-    mPreFilter.setSampleRate(samplerate);
-    mPostFilter.setSampleRate(samplerate);
+    mPrototype.mOversampler.setup(samplerate, mOversampling);
+    // ADAA averages the curve over the last one (first order) or two (second order) samples, delaying by half of that.
+    const double adaa_delay = 0.5 * static_cast<int>(mAdaaOrder) / mPrototype.mOversampler.getFactor();
+    mPrototype.mDryDelay.setDelay(static_cast<uint32_t>(std::lround(mPrototype.mOversampler.latency() + adaa_delay)));
+    mPreFilterRamp.setSampleRate(samplerate);
+    mPostFilterRamp.setSampleRate(samplerate);
+    mInputGain.setup(samplerate, 10.);
+    mOutputGain.setup(samplerate, 10.);
+    mMix.setup(samplerate, 10.);
     mDrive.setup(samplerate, 10.);
     mAsymmetry.setup(samplerate, 5.);
+    // A new processing starts from the current settings
+    for (auto* value : {&mInputGain, &mOutputGain, &mMix, &mDrive, &mAsymmetry, &mDriveModulation, &mAsymmetryModulation}) {
+        value->snap();
+    }
+    // The oversampling and ADAA setups are taken into account here.
+    mTailChanged = true;
+    // Propagate the new setup to the channel groups
+    reset();
 }
 
-void MultiDisto::reset() {
-    mPreFilter.reset();
-    mPostFilter.reset();
-    mDCBlocker = DCBlocker{};
+template <typename SampleType>
+void MultiDisto<SampleType>::setOversampling(const OversamplingSetup& setup) {
+    LOG_INFO("dsp", "[MultiDisto::setOversampling] factor = {}, method = {}, high_quality = {}", setup.factor,
+             static_cast<int>(setup.method), setup.high_quality);
+    mOversampling = setup;
 }
 
-double MultiDisto::process(double input) {
-    // Compute smoothing of values
-    smoothValues();
-
-    // Store dry signal for mix
-    double drySignal = input;
+template <typename SampleType>
+void MultiDisto<SampleType>::setAdaaOrder(AdaaOrder order) {
+    LOG_INFO("dsp", "[MultiDisto::setAdaaOrder] order = {}", static_cast<int>(order));
+    mAdaaOrder = order;
+}
 
-    // Apply input gain
-    double signal = input * mInputGain;
+template <typename SampleType>
+void MultiDisto<SampleType>::setChannelCount(uint32_t nb_channels) {
+    LOG_INFO("dsp", "[MultiDisto::setChannelCount] nb_channels = {}", nb_channels);
+    const auto nb_groups = std::max<uint32_t>(1, (nb_channels + kGroupSize - 1) / kGroupSize);
+    mGroups.assign(nb_groups, mPrototype);
+}
 
-    // Pre-filter
-    if (mPreFilterOn && mPreFilter.getType() != BiquadFilter::Type::None) {
-        signal = mPreFilter.process(signal);
-    }
+template <typename SampleType>
+void MultiDisto<SampleType>::reset() {
+    std::fill(mGroups.begin(), mGroups.end(), mPrototype);
+}
 
-    // Determine if non-linear stage can be bypassed (drive ~ 0dB and no asymmetry)
-    const bool bypassNonLinear = utils::almostEqual<double>(mDrive, 1.)
-                                && utils::almostEqual<double>(mAsymmetry, 0.);
+template <typename SampleType>
+void MultiDisto<SampleType>::setMaxBlockSize(uint32_t max_frames) {
+    const auto size = std::max(max_frames, kMaxBlockSize);
+    mDriveRamp.assign(size, SampleType(0));
+    mAsymmetryRamp.assign(size, SampleType(0));
+    mModulationRamp.assign(size, SampleType(0));
+    mInputGainRamp.assign(size, SampleType(0));
+    mWetGainRamp.assign(size, SampleType(0));
+    mDryGainRamp.assign(size, SampleType(0));
+    mPreFilterRamp.setMaxBlockSize(size);
+    mPostFilterRamp.setMaxBlockSize(size);
+}
 
-    if (!bypassNonLinear) {
-        // Oversampling for anti-aliasing on non-linear types (avoid for bitcrusher)
-        if (mType != DistortionType::BITCRUSHER) {
-            auto& upsampled = mOversampler.upsample(signal);
-            for (auto& sample : upsampled) {
-                sample = applyDistortion(sample);
-            }
-            signal = mOversampler.downsample();
-        } else {
-            signal = applyDistortion(signal);
+template <typename SampleType>
+void MultiDisto<SampleType>::processBlock(const SampleType* const* in, SampleType* const* out, uint32_t nb_channels,
+                                          uint32_t n) {
+    const auto max_block_size = static_cast<uint32_t>(mDriveRamp.size());
+    const auto nb_groups = groupCount(nb_channels);
+    for (uint32_t offset = 0; offset < n; offset += max_block_size) {
+        const auto block_size = std::min(n - offset, max_block_size);
+        beginBlock(block_size);
+        for (uint32_t g = 0; g < nb_groups; ++g) {
+            processGroupSlice(g, in, out, nb_channels, offset, block_size);
         }
-
-        // DC blocking (only needed when using non-linearities)
-        signal = mDCBlocker.process(signal);
     }
+}
 
-    // Post-filter
-    if (mPostFilterOn && mPostFilter.getType() != BiquadFilter::Type::None) {
-        signal = mPostFilter.process(signal);
+template <typename SampleType>
+void MultiDisto<SampleType>::beginBlock(uint32_t n) {
+    mDriveModulation.rampOver(n);
+    mAsymmetryModulation.rampOver(n);
+    mBypassNonLinear = canBypassNonLinear();
+    if (!mBypassNonLinear) {
+        renderSmoothedValues(n);
     }
 
-    // Apply output gain
-    signal *= mOutputGain;
-
-    // Wet/dry mix
-    signal = mMix * signal + (1.0 - mMix) * drySignal;
-
-    // Final soft safety limiting
-    return std::tanh(signal);
+    mInputGain.renderRamp(mInputGainRamp.data(), n);
+    mOutputGain.renderRamp(mWetGainRamp.data(), n);
+    mMix.renderRamp(mDryGainRamp.data(), n);
+    for (uint32_t i = 0; i < n; ++i) {
+        mWetGainRamp[i] *= mDryGainRamp[i];
+        mDryGainRamp[i] = SampleType(1) - mDryGainRamp[i];
+    }
+    // The filters follow their settings even when off, so they don't sweep from old settings when turned on.
+    mPreFilterRamp.render(n);
+    mPostFilterRamp.render(n);
 }
 
-void MultiDisto::smoothValues() {
-    mDrive.process();
-    mAsymmetry.process();
+template <typename SampleType>
+void MultiDisto<SampleType>::processGroup(uint32_t group_index, const SampleType* const* in, SampleType* const* out,
+                                          uint32_t nb_channels, uint32_t n) {
+    processGroupSlice(group_index, in, out, nb_channels, 0, n);
 }
 
-double MultiDisto::applyDistortion(double input) const {
-    switch (mType) {
-    case DistortionType::CUBIC_SATURATION:
-        return cubicSaturation(input);
-
-    case DistortionType::TUBE_SATURATION:
-        return tubeSaturation(input);
+template <typename SampleType>
+void MultiDisto<SampleType>::processGroupSlice(uint32_t group_index, const SampleType* const* in,
+                                               SampleType* const* out, uint32_t nb_channels, uint32_t offset,
+                                               uint32_t n) {
+    const auto first = group_index * kGroupSize;
+    auto& group = mGroups[group_index];
+    for (uint32_t chunk = 0; chunk < n; chunk += kMaxBlockSize) {
+        processGroupChunk(group, in + first, out + first, std::min(nb_channels - first, kGroupSize), offset + chunk,
+                          chunk, std::min(n - chunk, kMaxBlockSize));
+    }
+}
 
-    case DistortionType::ASYMMETRIC_CLIP:
-        return asymmetricClip(input);
+template <typename SampleType>
+uint32_t MultiDisto<SampleType>::groupCount(uint32_t nb_channels) const {
+    return std::min(static_cast<uint32_t>(mGroups.size()), (nb_channels + kGroupSize - 1) / kGroupSize);
+}
 
-    case DistortionType::FOLDBACK:
-        return foldbackDistortion(input);
+template <typename SampleType>
+void MultiDisto<SampleType>::processGroupChunk(ChannelGroup& group, const SampleType* const* in,
+                                               SampleType* const* out, uint32_t nb_channels, uint32_t offset,
+                                               uint32_t ramp_offset, uint32_t n) {
+    auto* dry = group.mDryBuffer.data();
+    auto* wet = group.mWetBuffer.data();
+
+    // Gather the channels into frames, the unused lanes of the last group stay silent.
+    for (uint32_t ch = 0; ch < kGroupSize; ++ch) {
+        const SampleType* channel = ch < nb_channels ? in[ch] + offset : nullptr;
+        for (uint32_t i = 0; i < n; ++i) {
+            dry[i][ch] = channel ? channel[i] : SampleType(0);
+        }
+    }
 
-    case DistortionType::BITCRUSHER:
-        return bitcrushDistortion(input);
+    // Store dry signal for mix and apply input gain.
+    // The dry signal is delayed to stay aligned with the oversampled wet signal at partial mix. When the shaping is
+    // bypassed, the wet signal is taken after the dry delay so the latency stays the same.
+    if (mBypassNonLinear) {
+        group.mDryDelay.processBuffer(dry, n);
+    }
+    const SampleType* input_gain = mInputGainRamp.data() + ramp_offset;
+    for (uint32_t i = 0; i < n; ++i) {
+        wet[i] = dry[i] * input_gain[i];
+    }
+    if (!mBypassNonLinear) {
+        group.mDryDelay.processBuffer(dry, n);
+    }
 
-    case DistortionType::WAVE_SHAPER:
-        return waveShaperDistortion(input);
+    // Pre-filter
+    if (mPreFilterSettings.on && mPreFilterRamp.getType() != FilterType::None) {
+        group.mPreFilter.processBuffer(mPreFilterRamp, wet, ramp_offset, n);
+    }
 
-    case DistortionType::TUBE_SCREAMER:
-        return tubeScreamerDistortion(input);
+    if (!mBypassNonLinear) {
+        applyShaping(group, wet, ramp_offset, n);
+        // DC blocking (only needed when using non-linearities)
+        group.mDCBlocker.processBuffer(wet, n);
+    }
 
-    case DistortionType::FUZZ_FACE:
-        return fuzzFaceDistortion(input);
+    // Post-filter
+    if (mPostFilterSettings.on && mPostFilterRamp.getType() != FilterType::None) {
+        group.mPostFilter.processBuffer(mPostFilterRamp, wet, ramp_offset, n);
+    }
 
-    default:
-        return input;
+    // Output gain, wet/dry mix
+    const SampleType* wet_gain = mWetGainRamp.data() + ramp_offset;
+    const SampleType* dry_gain = mDryGainRamp.data() + ramp_offset;
+    for (uint32_t i = 0; i < n; ++i) {
+        wet[i] = wet_gain[i] * wet[i] + dry_gain[i] * dry[i];
     }
-}
 
-double MultiDisto::cubicSaturation(double input) const {
-    double x = input * mDrive;
-    if (std::abs(x) < 2.0 / 3.0) {
-        return x * (1.0 + mAsymmetry * x);
+    // Final soft safety limiting, scattered back to the channels
+    fastmath::tanhBuffer(wet, n);
+    for (uint32_t ch = 0; ch < nb_channels; ++ch) {
+        SampleType* channel = out[ch] + offset;
+        for (uint32_t i = 0; i < n; ++i) {
+            channel[i] = wet[i][ch];
+        }
     }
-    double sign = (x > 0.0) ? 1.0 : -1.0;
-    return sign * (1.0 - std::pow(2.0 - 3.0 * std::abs(x), 2.0) / 3.0);
 }
 
-double MultiDisto::tubeSaturation(double input) const {
-    // Normalize tanh drive to avoid level jumps: y = tanh(g*x) / tanh(g)
-    double g = std::max(1e-6, 0.7 * (1.0 + mAsymmetry));
-    double x = input * mDrive;
-    double y = std::tanh(g * x);
-    double norm = std::tanh(g);
-    return (norm > 0.0 ? y / norm : y);
+template <typename SampleType>
+bool MultiDisto<SampleType>::isQuiet() const {
+    const auto threshold = static_cast<SampleType>(kSilenceLevel);
+    // The ADAA states are left as is when switching to a curve without ADAA, they only matter for the current curve.
+    const bool adaa_active = mAdaaOrder != AdaaOrder::Off;
+    return std::all_of(mGroups.begin(), mGroups.end(), [this, threshold, adaa_active](const ChannelGroup& group) {
+        return group.mPreFilter.isQuiet(threshold) && group.mPostFilter.isQuiet(threshold)
+            && group.mDCBlocker.isQuiet(threshold) && group.mOversampler.isQuiet(threshold)
+            && group.mDecimator.isQuiet(threshold) && group.mDryDelay.isQuiet(threshold)
+            && (!adaa_active || group.mAdaaType != mType
+                || std::all_of(group.mAdaaStates.begin(), group.mAdaaStates.end(), [threshold](const adaa::State& s) {
+                       return std::fabs(s.x1) < threshold && std::fabs(s.x2) < threshold;
+                   }));
+    });
 }
 
-double MultiDisto::asymmetricClip(double input) const {
-    double x = input * mDrive;
-    double posThresh = 0.7 + mAsymmetry * 0.3;
-    double negThresh = -0.7 - mAsymmetry * 0.3;
-
-    if (x > posThresh) {
-        return posThresh + (x - posThresh) * 0.1;
+template <typename SampleType>
+uint32_t MultiDisto<SampleType>::tailSamples() const {
+    // The stages run in series, so the sum of their decay times bounds the tail.
+    const auto& group = mPrototype;
+    double tail = group.mOversampler.decaySamples(kSilenceLevel) + group.mDCBlocker.decaySamples(kSilenceLevel)
+                + static_cast<double>(mAdaaOrder) / group.mOversampler.getFactor();
+    if (mPreFilterSettings.on) {
+        tail += mPreFilterRamp.decaySamples(kSilenceLevel);
     }
-    if (x < negThresh) {
-        return negThresh + (x - negThresh) * 0.1;
+    if (mPostFilterSettings.on) {
+        tail += mPostFilterRamp.decaySamples(kSilenceLevel);
     }
-    return x;
+    return static_cast<uint32_t>(std::ceil(tail));
 }
 
-double MultiDisto::foldbackDistortion(double input) const {
-    double x = input * mDrive;
-    constexpr double threshold = 1.0;
+template <typename SampleType>
+bool MultiDisto<SampleType>::canBypassNonLinear() const {
+    // The non-linear stage can be skipped when drive ~ 0dB and no asymmetry for the whole block,
+    // meaning the smoothed values and the modulation have also reached their targets.
+    return mDrive.isSettled() && mAsymmetry.isSettled() && mDriveModulation.isSettled()
+        && mAsymmetryModulation.isSettled()
+        && utils::almostEqual<SampleType>(mDrive * mDriveModulation, SampleType(1))
+        && utils::almostEqual<SampleType>(mAsymmetry + mAsymmetryModulation, SampleType(0));
+}
 
-    // Modulo-based foldback into [-threshold, threshold]
-    const double ax = std::abs(x);
-    double y = std::fmod(ax, 2.0 * threshold);
-    if (y > threshold) {
-        y = 2.0 * threshold - y;
+template <typename SampleType>
+void MultiDisto<SampleType>::renderSmoothedValues(uint32_t n) {
+    mDrive.renderRamp(mDriveRamp.data(), n);
+    mDriveModulation.renderRamp(mModulationRamp.data(), n);
+    for (uint32_t i = 0; i < n; ++i) {
+        mDriveRamp[i] *= mModulationRamp[i];
+    }
+    mAsymmetry.renderRamp(mAsymmetryRamp.data(), n);
+    mAsymmetryModulation.renderRamp(mModulationRamp.data(), n);
+    for (uint32_t i = 0; i < n; ++i) {
+        mAsymmetryRamp[i] += mModulationRamp[i];
     }
-    y = std::copysign(y, x);
-
-    return y * 0.7; // Scale down to prevent excessive levels
 }
 
-double MultiDisto::bitcrushDistortion(double input) const {
-    // Map drive (in dB) to a 0..1 control for bit depth and rate reduction
-    double driveDbNorm = std::clamp(utils::linearToDB(mDrive) / kMaxDriveDb, 0.0, 1.0);
-
-    // Bit depth: from 16 bits (low drive) down to 4 bits (high drive)
-    int bits = 4 + static_cast<int>(std::round((1.0 - driveDbNorm) * 12.0));
-    bits = std::clamp(bits, 1, 24);
-    double levels = std::pow(2.0, bits) - 1.0;
-
-    // Sample-rate reduction: hold every N samples, from 1 (no SRR) up to ~40 at max drive
-    const int holdN = 1 + static_cast<int>(std::round(driveDbNorm * 39.0));
-
-    // Quantize a clipped version of the signal to avoid explosive outputs
-    double x = std::clamp(input, -1.0, 1.0);
+template <typename SampleType>
+void MultiDisto<SampleType>::applyShaping(ChannelGroup& group, Frame* samples, uint32_t ramp_offset, uint32_t n) {
+    // Block function of each DistortionType, in the order of the enum. A new type only needs its entry here.
+    static constexpr std::array<ShapingFunction, kNbDistortionTypes> kShapingFunctions = {
+        &MultiDisto::applyKernel<kernels::CubicSaturation<SampleType>>,
+        &MultiDisto::applyKernel<kernels::TubeSaturation<SampleType>>,
+        &MultiDisto::applyKernel<kernels::AsymmetricClip<SampleType>>,
+        &MultiDisto::applyKernel<kernels::Foldback<SampleType>>,
+        &MultiDisto::applyBitcrush,
+        &MultiDisto::applyKernel<kernels::WaveShaper<SampleType>>,
+        &MultiDisto::applyKernel<kernels::TubeScreamer<SampleType>>,
+        &MultiDisto::applyKernel<kernels::FuzzFace<SampleType>>,
+    };
+    (this->*kShapingFunctions[static_cast<std::size_t>(mType)])(group, samples, ramp_offset, n);
+}
 
-    if (mBitcrushPhase == 0) {
-        mBitcrushHold = std::round(x * levels) / levels;
+template <typename SampleType>
+template <typename Kernel>
+void MultiDisto<SampleType>::applyKernel(ChannelGroup& group, Frame* samples, uint32_t ramp_offset, uint32_t n) {
+    if constexpr (requires { typename Kernel::Curve; }) {
+        if (mAdaaOrder != AdaaOrder::Off) {
+            return applyAdaaShaping<typename Kernel::Curve>(group, samples, ramp_offset, n);
+        }
     }
-    mBitcrushPhase = (mBitcrushPhase + 1) % holdN;
-
-    return mBitcrushHold;
+    applyOversampledShaping<Kernel>(group, samples, ramp_offset, n);
 }
 
-double MultiDisto::waveShaperDistortion(double input) const {
-    double x = input * mDrive;
-    // Sigmoid-based waveshaping
-    double k = 2.0 * mDrive;
-    return x * (1.0 + k) / (1.0 + k * std::abs(x));
+template <typename SampleType>
+void MultiDisto<SampleType>::applyBitcrush(ChannelGroup& group, Frame* samples, uint32_t ramp_offset, uint32_t n) {
+    // No oversampling for the bitcrusher, aliasing is part of the sound.
+    group.mDecimator.processBuffer(samples, mDriveRamp.data() + ramp_offset, n);
 }
 
-double MultiDisto::tubeScreamerDistortion(double input) const {
-    // Tube Screamer-inspired soft clipping
-    double x = input * mDrive * 2.0;
-    double sign = (x >= 0.0) ? 1.0 : -1.0;
-    x = std::abs(x);
+template <typename SampleType>
+template <typename Kernel>
+void MultiDisto<SampleType>::applyOversampledShaping(ChannelGroup& group, Frame* samples, uint32_t ramp_offset,
+                                                     uint32_t n) {
+    constexpr auto kOversamplerBlockSize = Oversampler<Frame>::kMaxBlockSize;
+    const uint32_t factor = group.mOversampler.getFactor();
+    for (uint32_t offset = 0; offset < n; offset += kOversamplerBlockSize) {
+        const uint32_t block_size = std::min(n - offset, kOversamplerBlockSize);
+        const SampleType* drive_ramp = mDriveRamp.data() + ramp_offset + offset;
+        const SampleType* asymmetry_ramp = mAsymmetryRamp.data() + ramp_offset + offset;
+
+        auto upsampled = group.mOversampler.upsample(samples + offset, block_size);
+        // The control values stay constant over the oversampled frames of a base rate sample.
+        for (uint32_t i = 0; i < block_size; ++i) {
+            const SampleType drive = drive_ramp[i];
+            const SampleType asymmetry = asymmetry_ramp[i];
+            for (auto& frame : upsampled.subspan(i * factor, factor)) {
+                frame = map(frame, [drive, asymmetry](SampleType x) { return Kernel::process(x, drive, asymmetry); });
+            }
+        }
+        group.mOversampler.downsample(samples + offset, block_size);
+    }
+}
 
-    if (x < 1.0 / 3.0) {
-        return sign * 2.0 * x;
-    } else if (x < 2.0 / 3.0) {
-        return sign * (3.0 - std::pow(2.0 - 3.0 * x, 2.0)) / 3.0;
+template <typename SampleType>
+template <typename Curve>
+void MultiDisto<SampleType>::applyAdaaShaping(ChannelGroup& group, Frame* samples, uint32_t ramp_offset, uint32_t n) {
+    if (mAdaaOrder == AdaaOrder::Second) {
+        applyAdaaShaping<Curve, AdaaOrder::Second>(group, samples, ramp_offset, n);
     } else {
-        return sign;
+        applyAdaaShaping<Curve, AdaaOrder::First>(group, samples, ramp_offset, n);
     }
 }
 
-double MultiDisto::fuzzFaceDistortion(double input) const {
-    // Fuzz Face-inspired germanium transistor distortion
-    double x = input * mDrive * 1.5;
-    double sign = (x >= 0.0) ? 1.0 : -1.0;
-    x = std::abs(x);
-
-    // Asymmetric germanium-like curve
-    double pos_curve = 1.0 - std::exp(-x * (2.0 + mAsymmetry));
-    double neg_curve = 1.0 - std::exp(-x * (2.0 - mAsymmetry));
+template <typename SampleType>
+template <typename Curve, AdaaOrder order>
+void MultiDisto<SampleType>::applyAdaaShaping(ChannelGroup& group, Frame* samples, uint32_t ramp_offset, uint32_t n) {
+    if (group.mAdaaType != mType) {
+        group.mAdaaType = mType;
+        group.mAdaaDrive = 0;
+    }
 
-    return sign * (sign > 0 ? pos_curve : neg_curve) * 0.8;
+    constexpr auto kOversamplerBlockSize = Oversampler<Frame>::kMaxBlockSize;
+    const uint32_t factor = group.mOversampler.getFactor();
+    Curve curve(group.mAdaaDrive, group.mAdaaAsymmetry);
+    for (uint32_t offset = 0; offset < n; offset += kOversamplerBlockSize) {
+        const uint32_t block_size = std::min(n - offset, kOversamplerBlockSize);
+        const SampleType* drive_ramp = mDriveRamp.data() + ramp_offset + offset;
+        const SampleType* asymmetry_ramp = mAsymmetryRamp.data() + ramp_offset + offset;
+
+        auto upsampled = group.mOversampler.upsample(samples + offset, block_size);
+        for (uint32_t i = 0; i < block_size; ++i) {
+            // The cached antiderivatives are only valid for the curve parameters they were computed with.
+            if (drive_ramp[i] != group.mAdaaDrive || asymmetry_ramp[i] != group.mAdaaAsymmetry) {
+                group.mAdaaDrive = drive_ramp[i];
+                group.mAdaaAsymmetry = asymmetry_ramp[i];
+                curve = Curve(group.mAdaaDrive, group.mAdaaAsymmetry);
+                for (auto& state : group.mAdaaStates) {
+                    adaa::refresh<order>(curve, state);
+                }
+            }
+            for (auto& frame : upsampled.subspan(i * factor, factor)) {
+                for (uint32_t ch = 0; ch < kGroupSize; ++ch) {
+                    const double x = curve.gain * frame[ch];
+                    frame[ch] = static_cast<SampleType>(adaa::process<order>(curve, group.mAdaaStates[ch], x));
+                }
+            }
+        }
+        group.mOversampler.downsample(samples + offset, block_size);
+    }
 }
 
+template class MultiDisto<float>;
+template class MultiDisto<double>;
+
 } // namespace stfefane::dsp
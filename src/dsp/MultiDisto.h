@@ -1,17 +1,21 @@
 #pragma once
 
+#include "Adaa.h"
 #include "BiquadFilter.h"
+#include "Decimator.h"
+#include "DelayLine.h"
+#include "FilterRamp.h"
 #include "OverSampler.h"
+#include "Simd.h"
 #include "SmoothedValue.h"
+#include "SvfFilter.h"
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <utility>
 #include <vector>
 
-namespace stfefane {
-namespace params {
-class ParameterAttachment;
-}
-class Disstortion;
-} // namespace stfefane
-
 namespace stfefane::dsp {
 
 enum class DistortionType {
@@ -25,77 +29,243 @@ enum class DistortionType {
     FUZZ_FACE
 };
 
+static constexpr std::size_t kNbDistortionTypes = static_cast<std::size_t>(DistortionType::FUZZ_FACE) + 1;
+
+static constexpr std::array<std::string_view, kNbDistortionTypes> kDistortionTypeNames = {
+    "Cubic Saturation", "Tube Saturation", "Asymmetric Clip", "Foldback",
+    "Bitcrush",         "Waveshaper",      "Tube Screamer",   "Fuzz"};
+
 static constexpr double kMaxDriveDb = 36.;
 
+struct FilterSettings {
+    bool on = true;
+    FilterType type = FilterType::LowPass;
+    double freq = 1000.; // Hz
+    double q = 0.707;
+    double gain_db = 0.;
+    double freq_modulation = 0.; // Octaves
+
+    bool operator==(const FilterSettings&) const = default;
+};
+
+// Parameter values in the units of the processing, given to the engine at the start of each block.
+// The conversion from the normalized values happens once for all the channels and both precisions.
+struct DspParameters {
+    // Changes with the values or the modulation, so the engine only applies a snapshot once
+    uint64_t version = 0;
+    DistortionType type = DistortionType::CUBIC_SATURATION;
+    double drive = 1.; // Linear gains
+    double drive_modulation = 1.; // Gain on top of the drive
+    double input_gain = 1.;
+    double output_gain = 1.;
+    double asymmetry = 0.;
+    double asymmetry_modulation = 0.; // Offset on top of the asymmetry
+    double mix = 1.; // Wet/dry mix in [0, 1]
+    FilterSettings pre_filter{true, FilterType::LowPass, 10000.};
+    FilterSettings post_filter{true, FilterType::HighPass, 80.};
+    FilterTopology filter_topology = FilterTopology::Biquad;
+};
+
+// The whole processing chain runs in SampleType, which is float or double.
+// Both versions are explicitly instantiated in MultiDisto.cpp.
+// The engine is channel count agnostic: channels are packed kGroupSize at a time in the lanes of a Frame,
+// and every stage runs on these lane groups, with one set of filter, oversampler and DC blocker states per group.
+// Stereo fits in a single group, a 7.1.4 bus takes 3 groups of floats or 6 groups of doubles.
+template <typename SampleType>
 class MultiDisto {
 public:
+    // Channels processed together, sized to fill a 128-bit register (4 floats or 2 doubles).
+    static constexpr uint32_t kGroupSize = 16 / sizeof(SampleType);
+    using Frame = Lanes<SampleType, kGroupSize>;
+
     MultiDisto() = default;
 
-    void initParameterAttachments(const Disstortion& d);
+    // Adopt the parameter values, the smoothed ones ramping from their current value. Called before processing a block.
+    void setParameters(const DspParameters& parameters);
 
     void setSampleRate(double samplerate);
+    // Oversampling of the shaping stage, taken into account by the next setSampleRate.
+    void setOversampling(const OversamplingSetup& setup);
+    // Antiderivative anti-aliasing of the curves that support it, taken into account by the next setSampleRate.
+    // It runs at the oversampled rate, and can replace the oversampling or complement a low factor.
+    void setAdaaOrder(AdaaOrder order);
+    // Allocates the channel groups states, must not be called while processing.
+    void setChannelCount(uint32_t nb_channels);
+    // Allocates the buffers shared by the groups for blocks of up to max_frames samples.
+    void setMaxBlockSize(uint32_t max_frames);
     void reset();
 
-    double process(double input);
+    // Process whole channel buffers, each stage of the chain running over the block at once.
+    // in and out may point to the same buffers, nb_channels must not exceed the count given to setChannelCount.
+    void processBlock(const SampleType* const* in, SampleType* const* out, uint32_t nb_channels, uint32_t n);
+
+    // processBlock split in two steps, so the channel groups can run on different threads:
+    // beginBlock renders the values shared by all the groups for n samples (up to the max block size),
+    // then processGroup is called once for each group, in any order and possibly concurrently.
+    void beginBlock(uint32_t n);
+    void processGroup(uint32_t group_index, const SampleType* const* in, SampleType* const* out, uint32_t nb_channels,
+                      uint32_t n);
+    [[nodiscard]] uint32_t groupCount(uint32_t nb_channels) const;
 
-    static constexpr std::vector<std::string> types() {
-        return {"Cubic Saturation", "Tube Saturation", "Asymmetric Clip", "Foldback",
-                "Bitcrush",         "Waveshaper",      "Tube Screamer",   "Fuzz"};
-    }
+    // True when every internal state has decayed below the silence level, so silent input gives silent output.
+    [[nodiscard]] bool isQuiet() const;
+    // Number of samples the chain keeps ringing once the input is silent, for the current settings.
+    [[nodiscard]] uint32_t tailSamples() const;
+    // True once after the filters, oversampling or ADAA changed, so the tail only needs computing again then.
+    [[nodiscard]] bool consumeTailChange() { return std::exchange(mTailChanged, false); }
+    // Delay of the wet path introduced by the oversampling and ADAA, the dry path is delayed by the same amount.
+    [[nodiscard]] uint32_t latencySamples() const { return mPrototype.mDryDelay.getDelay(); }
 
 private:
+    // -100dB, below which the states are considered silent
+    static constexpr double kSilenceLevel = 1e-5;
+
     // DC blocking filter
     struct DCBlocker {
-        double x1 = 0.0, y1 = 0.0;
-        double R = 0.995; // pole location (close to 1 for DC blocking)
-
-        double process(double input) {
-            double output = input - x1 + R * y1;
-            // Denormal protection
-            if (std::abs(output) < 1e-20) {
-                output = 0.0;
-            }
+        Frame x1 = 0, y1 = 0;
+        SampleType R = SampleType(0.995); // pole location (close to 1 for DC blocking)
+
+        Frame process(const Frame& input) {
+            const Frame output = input - x1 + R * y1;
             x1 = input;
             y1 = output;
             return output;
         }
+
+        void processBuffer(Frame* samples, std::size_t count) {
+            for (std::size_t i = 0; i < count; ++i) {
+                samples[i] = process(samples[i]);
+            }
+        }
+
+        [[nodiscard]] bool isQuiet(SampleType threshold) const {
+            return maxAbs(x1) < threshold && maxAbs(y1) < threshold;
+        }
+
+        [[nodiscard]] double decaySamples(double ratio) const {
+            return std::log(ratio) / std::log(static_cast<double>(R));
+        }
+    };
+
+    // Pre or post filter state of a group, the coefficients coming from a FilterRamp shared by all the groups.
+    // Only the topology selected by the ramp processes, the other one is reset when switching.
+    struct FilterStage {
+        BiquadFilter<Frame> mBiquad;
+        SvfFilter<Frame> mSvf;
+
+        void reset() {
+            mBiquad.reset();
+            mSvf.reset();
+        }
+
+        void processBuffer(const FilterRamp<SampleType>& ramp, Frame* samples, uint32_t ramp_offset, uint32_t count) {
+            if (ramp.getTopology() == FilterTopology::StateVariable) {
+                mSvf.processBuffer(samples, ramp.coefficients(ramp_offset), count);
+            } else {
+                mBiquad.processBuffer(samples, ramp.coefficients(ramp_offset), count);
+            }
+        }
+
+        [[nodiscard]] bool isQuiet(SampleType threshold) const {
+            return mBiquad.isQuiet(threshold) && mSvf.isQuiet(threshold);
+        }
     };
 
-    void smoothValues();
+    // Internal buffers size, bigger host blocks are processed in chunks of this size.
+    static constexpr uint32_t kMaxBlockSize = 256;
+
+    // Processing state of one group of channels
+    struct ChannelGroup {
+        FilterStage mPreFilter;
+        FilterStage mPostFilter;
+        DCBlocker mDCBlocker;
+        Oversampler<Frame> mOversampler;
+        DelayLine<Frame> mDryDelay;
+
+        // Bitcrusher bit depth and sample-rate reduction
+        Decimator<Frame> mDecimator{kMaxDriveDb};
+
+        // ADAA states of each channel, and the curve their cached antiderivatives were computed with.
+        // A drive of 0 never happens and forces a refresh.
+        std::array<adaa::State, kGroupSize> mAdaaStates = {};
+        DistortionType mAdaaType = DistortionType::TUBE_SCREAMER;
+        SampleType mAdaaDrive = 0;
+        SampleType mAdaaAsymmetry = 0;
+
+        // Scratch buffers, owned by the group so that groups can be processed concurrently
+        std::array<Frame, kMaxBlockSize> mDryBuffer = {};
+        std::array<Frame, kMaxBlockSize> mWetBuffer = {};
+    };
+
+    // Shapes n samples of a group, with the control ramps starting at ramp_offset.
+    // There's one per DistortionType, selected once per block.
+    using ShapingFunction = void (MultiDisto::*)(ChannelGroup& group, Frame* samples, uint32_t ramp_offset, uint32_t n);
+
+    // Process a group over the block started with beginBlock, starting at offset in the buffers.
+    void processGroupSlice(uint32_t group_index, const SampleType* const* in, SampleType* const* out,
+                           uint32_t nb_channels, uint32_t offset, uint32_t n);
+    // Process the channels of a group starting at offset in the buffers, the control ramps starting at ramp_offset.
+    void processGroupChunk(ChannelGroup& group, const SampleType* const* in, SampleType* const* out,
+                           uint32_t nb_channels, uint32_t offset, uint32_t ramp_offset, uint32_t n);
+
+    static void setFilterSettings(FilterRamp<SampleType>& ramp, const FilterSettings& settings);
+    // Switch the pre and post filters topology, the newly selected filters starting from a clean state.
+    void setFilterTopology(FilterTopology topology);
+
+    [[nodiscard]] bool canBypassNonLinear() const;
+    void renderSmoothedValues(uint32_t n);
+    void applyShaping(ChannelGroup& group, Frame* samples, uint32_t ramp_offset, uint32_t n);
 
-    [[nodiscard]] double applyDistortion(double input) const;
+    // Block function of a kernel from DistortionKernels.h, running its ADAA version when available and enabled.
+    template <typename Kernel>
+    void applyKernel(ChannelGroup& group, Frame* samples, uint32_t ramp_offset, uint32_t n);
+    template <typename Kernel>
+    void applyOversampledShaping(ChannelGroup& group, Frame* samples, uint32_t ramp_offset, uint32_t n);
+    template <typename Curve>
+    void applyAdaaShaping(ChannelGroup& group, Frame* samples, uint32_t ramp_offset, uint32_t n);
+    template <typename Curve, AdaaOrder order>
+    void applyAdaaShaping(ChannelGroup& group, Frame* samples, uint32_t ramp_offset, uint32_t n);
 
-    // Distortion algorithms
-    [[nodiscard]] double cubicSaturation(double input) const;
-    [[nodiscard]] double tubeSaturation(double input) const;
-    [[nodiscard]] double asymmetricClip(double input) const;
-    [[nodiscard]] double foldbackDistortion(double input) const;
-    [[nodiscard]] double bitcrushDistortion(double input) const;
-    [[nodiscard]] double waveShaperDistortion(double input) const;
-    [[nodiscard]] double tubeScreamerDistortion(double input) const;
-    [[nodiscard]] double fuzzFaceDistortion(double input) const;
+    // The bitcrusher keeps a state across samples, it has its own block function.
+    void applyBitcrush(ChannelGroup& group, Frame* samples, uint32_t ramp_offset, uint32_t n);
 
     double mSampleRate = 44100.0;
+    OversamplingSetup mOversampling;
+    AdaaOrder mAdaaOrder = AdaaOrder::Off;
     DistortionType mType = DistortionType::TUBE_SCREAMER;
 
-    BiquadFilter mPreFilter{BiquadFilter::Type::LowPass, 10000.};
-    BiquadFilter mPostFilter{BiquadFilter::Type::HighPass, 80.};
-    DCBlocker mDCBlocker;
-    Oversampler mOversampler;
+    // Holds the current filters and oversampler setup, new and reset groups are copied from it.
+    ChannelGroup mPrototype;
+    std::vector<ChannelGroup> mGroups = std::vector<ChannelGroup>(1);
 
-    // State for bitcrusher sample-rate reduction
-    mutable int mBitcrushPhase = 0;
-    mutable double mBitcrushHold = 0.0;
+    // Smoothed values rendered once per block by beginBlock, so every group follows the same trajectory
+    std::vector<SampleType> mDriveRamp = std::vector<SampleType>(kMaxBlockSize);
+    std::vector<SampleType> mAsymmetryRamp = std::vector<SampleType>(kMaxBlockSize);
+    // Host modulation of the drive or asymmetry, combined into their ramps
+    std::vector<SampleType> mModulationRamp = std::vector<SampleType>(kMaxBlockSize);
+    std::vector<SampleType> mInputGainRamp = std::vector<SampleType>(kMaxBlockSize);
+    // Output gain and mix folded into the gains of the wet and dry signals
+    std::vector<SampleType> mWetGainRamp = std::vector<SampleType>(kMaxBlockSize);
+    std::vector<SampleType> mDryGainRamp = std::vector<SampleType>(kMaxBlockSize);
+    FilterRamp<SampleType> mPreFilterRamp{FilterType::LowPass, 10000., kMaxBlockSize};
+    FilterRamp<SampleType> mPostFilterRamp{FilterType::HighPass, 80., kMaxBlockSize};
+    bool mBypassNonLinear = true;
 
-    std::vector<params::ParameterAttachment> mParameterAttachments;
+    // Version of the last parameters applied, none at first
+    std::optional<uint64_t> mParametersVersion;
 
-    double mInputGain = 0.;
-    double mOutputGain = 0.;
-    SmoothedValue mDrive;
-    SmoothedValue mAsymmetry; // For asymmetric distortion
-    double mMix = 1.;         // Wet/dry mix
-    bool mPreFilterOn = true;
-    bool mPostFilterOn = true;
+    SmoothedValue<SampleType> mInputGain;
+    SmoothedValue<SampleType> mOutputGain;
+    SmoothedValue<SampleType> mDrive;
+    SmoothedValue<SampleType> mAsymmetry; // For asymmetric distortion
+    // The host modulation changes at every block, it ramps over each block instead of the default duration.
+    SmoothedValue<SampleType> mDriveModulation;
+    SmoothedValue<SampleType> mAsymmetryModulation;
+    SmoothedValue<SampleType> mMix;       // Wet/dry mix
+    FilterSettings mPreFilterSettings{true, FilterType::LowPass, 10000.};
+    FilterSettings mPostFilterSettings{true, FilterType::HighPass, 80.};
+    bool mTailChanged = true;
+    FilterTopology mFilterTopology = FilterTopology::Biquad;
 };
 
 } // namespace stfefane::dsp
\ No newline at end of file
@@ -1,69 +1,253 @@
 #include "OverSampler.h"
 
+#include <algorithm>
+#include <cmath>
+
 namespace stfefane::dsp {
 
-void Oversampler::setupAntiAliasing(double sampleRate) {
-    // Both filters operate in the oversampled domain (fs * FACTOR)
-    const double fsOS = sampleRate * static_cast<double>(FACTOR);
+// Half-band kernels as {half length, Kaiser beta}, to the spec of the allpass method below. Relative to the output
+// rate of the stage, the first stage passes up to 0.22 (0.23) and attenuates by 104dB (125dB) from 0.28 (0.27),
+// with a passband ripple under 1e-4dB. Only the transition band folds back into the audio band, above 0.44 of the
+// base rate (19.4kHz at 44.1kHz).
+// The next ones run at higher rates where the images are far away from the audio band, they pass up to 0.15 and
+// attenuate by 106dB (125dB) from 0.35 with much shorter kernels.
+static const std::vector<double>& halfBandKernel(bool first_stage, bool high_quality) {
+    static const std::array<std::vector<double>, 4> kernels = {
+        designHalfBand(30, 10.5), designHalfBand(54, 13.), // first stage
+        designHalfBand(10, 11.), designHalfBand(11, 13.),  // next stages
+    };
+    return kernels[(first_stage ? 0 : 2) + (high_quality ? 1 : 0)];
+}
+
+// Allpass half-band coefficients, designed from {attenuation in dB, transition bandwidth} with the same split.
+// The first stage passes up to 0.22 (0.23) of its output rate with 100dB (120dB) of attenuation from 0.28 (0.27),
+// the next ones up to 0.15 with the same attenuations from 0.35.
+static const std::vector<double>& halfBandAllpassCoefficients(bool first_stage, bool high_quality) {
+    static const std::array<std::vector<double>, 4> coefficients = {
+        designHalfBandAllpass(100., 0.03), designHalfBandAllpass(120., 0.02), // first stage
+        designHalfBandAllpass(100., 0.1), designHalfBandAllpass(120., 0.1),   // next stages
+    };
+    return coefficients[(first_stage ? 0 : 2) + (high_quality ? 1 : 0)];
+}
+
+template <typename SampleType>
+void Oversampler<SampleType>::setup(double sampleRate, const OversamplingSetup& setup) {
+    mMethod = setup.method;
+    mFactor = 1;
+    mNbStages = 0;
+    while (mFactor < std::min(setup.factor, kMaxFactor)) {
+        mFactor *= 2;
+        ++mNbStages;
+    }
+
+    // Polyphase FIR cascade. Stage s runs at 2^s times the base rate and delays the signal by its latency at
+    // that rate, the alignment delay rounds the sum up to whole base rate samples.
+    uint32_t stage_input = kMaxBlockSize;
+    uint32_t top_rate_latency = 0;
+    for (uint32_t s = 0; s < mNbStages; ++s) {
+        mStages[s].setup(halfBandKernel(s == 0, setup.high_quality), stage_input);
+        top_rate_latency += mStages[s].latency() * (mFactor >> s);
+        stage_input *= 2;
+    }
+    mAlignmentDelay.setDelay((mFactor - top_rate_latency % mFactor) % mFactor);
+
+    // Allpass cascade, its latency is not a whole number of samples and can't be aligned without losing its point.
+    for (uint32_t s = 0; s < mNbStages; ++s) {
+        mAllpassStages[s].setup(halfBandAllpassCoefficients(s == 0, setup.high_quality));
+    }
 
-    mAntiImagingFilter.setSampleRate(fsOS);
-    mAntiAliasFilter.setSampleRate(fsOS);
+    // Hermite interpolation and Butterworth filters, both operating in the oversampled domain (fs * factor)
+    const double fsOS = sampleRate * static_cast<double>(mFactor);
 
     // Keep passband up to ~0.45 * original Nyquist to leave some transition band
     const double cutoff = sampleRate * 0.45; // equals 0.45 * (fs/2)
 
-    mAntiImagingFilter.setup(BiquadFilter::Type::LowPass, cutoff, 0.707);
-    mAntiAliasFilter.setup(BiquadFilter::Type::LowPass, cutoff, 0.707);
+    // Butterworth response split in 2nd order sections, the section k having Q = 1 / (2 cos((2k + 1) pi / 2N))
+    // Without oversampling there's nothing to filter, the interpolation falls back to the input samples.
+    mNbSections = mFactor == 1 ? 0 : (setup.high_quality ? kMaxSections : 1);
+    const double order = 2.0 * mNbSections;
+    for (auto* filter : {&mAntiImagingFilter, &mAntiAliasFilter}) {
+        filter->setNbStages(mNbSections);
+        for (uint32_t k = 0; k < mNbSections; ++k) {
+            const double q = 1.0 / (2.0 * std::cos((2.0 * k + 1.0) * utils::kPI_64 / (2.0 * order)));
+            filter->setCoefficients(k, designBiquad(FilterType::LowPass, fsOS, cutoff, q));
+        }
+    }
+
+    // Samples generated at t = 1/factor, 2/factor ... 1 of the segment [x0 -> x1]
+    using Scalar = ScalarOf<SampleType>;
+    for (uint32_t i = 0; i < mFactor; ++i) {
+        const double t = static_cast<double>(i + 1) / mFactor;
+        const double t2 = t * t;
+        const double t3 = t2 * t;
+        mHermiteWeights[i] = {static_cast<Scalar>(2.0 * t3 - 3.0 * t2 + 1.0), static_cast<Scalar>(t3 - 2.0 * t2 + t),
+                              static_cast<Scalar>(-2.0 * t3 + 3.0 * t2), static_cast<Scalar>(t3 - t2)};
+    }
 
     // Reset interpolation state
-    mPrevInput = 0.0;
-    mPrevSlope = 0.0;
+    mPrevInput = SampleType(0);
+    mPrevSlope = SampleType(0);
 }
 
-std::array<double, Oversampler::FACTOR>& Oversampler::upsample(double input) {
-    // Cubic Hermite interpolation between previous and current input samples
-    const double x0 = mPrevInput;
-    const double x1 = input;
+template <typename SampleType>
+std::span<SampleType> Oversampler<SampleType>::upsample(const SampleType* input, uint32_t n) {
+    mOutputBuffer = 0;
+    switch (mMethod) {
+        case OversamplingMethod::HalfBandFir:
+            upsampleCascade(mStages, input, n);
+            break;
+        case OversamplingMethod::HalfBandIir:
+            upsampleCascade(mAllpassStages, input, n);
+            break;
+        case OversamplingMethod::HermiteBiquad:
+            upsampleHermite(input, mBuffers[0].data(), n);
+            break;
+    }
+    return {mBuffers[mOutputBuffer].data(), n * mFactor};
+}
 
-    // Estimate slopes using finite differences
-    const double m0 = mPrevSlope;         // slope at previous sample
-    const double m1 = (x1 - x0);          // slope at current sample (simple estimate)
+template <typename SampleType>
+template <typename Stage>
+void Oversampler<SampleType>::upsampleCascade(std::array<Stage, kMaxStages>& stages, const SampleType* input, uint32_t n) {
+    // Each stage doubles the number of samples, alternating between the two buffers.
+    const SampleType* stage_input = input;
+    uint32_t stage_size = n;
+    for (uint32_t s = 0; s < mNbStages; ++s) {
+        mOutputBuffer = s % 2;
+        stages[s].upsample(stage_input, mBuffers[mOutputBuffer].data(), stage_size);
+        stage_input = mBuffers[mOutputBuffer].data();
+        stage_size *= 2;
+    }
+    if (mNbStages == 0) {
+        std::copy_n(input, n, mBuffers[0].data());
+    }
+}
 
-    // Generate 4 samples at t = 0.25, 0.5, 0.75, 1.0 of the segment [x0 -> x1]
-    auto hermite = [&](double t) {
-        const double t2 = t * t;
-        const double t3 = t2 * t;
-        const double h00 = 2.0 * t3 - 3.0 * t2 + 1.0;
-        const double h10 = t3 - 2.0 * t2 + t;
-        const double h01 = -2.0 * t3 + 3.0 * t2;
-        const double h11 = t3 - t2;
-        return h00 * x0 + h10 * m0 + h01 * x1 + h11 * m1;
-    };
+template <typename SampleType>
+void Oversampler<SampleType>::upsampleHermite(const SampleType* input, SampleType* output, uint32_t n) {
+    for (uint32_t i = 0; i < n; ++i) {
+        // Cubic Hermite interpolation between previous and current input samples
+        const SampleType x0 = mPrevInput;
+        const SampleType x1 = input[i];
+
+        // Estimate slopes using finite differences
+        const SampleType m0 = mPrevSlope; // slope at previous sample
+        const SampleType m1 = (x1 - x0);  // slope at current sample (simple estimate)
+
+        SampleType* frame = output + i * mFactor;
+        for (uint32_t k = 0; k < mFactor; ++k) {
+            const auto& h = mHermiteWeights[k];
+            frame[k] = h[0] * x0 + h[1] * m0 + h[2] * x1 + h[3] * m1;
+        }
 
-    // Fill buffer with interpolated values then run anti-imaging filter through them sequentially
-    buffer[0] = hermite(0.25);
-    buffer[1] = hermite(0.5);
-    buffer[2] = hermite(0.75);
-    buffer[3] = hermite(1.0);
+        // Update state for next call
+        mPrevSlope = m1;
+        mPrevInput = x1;
+    }
+
+    // Run anti-imaging filter through the interpolated values
+    mAntiImagingFilter.processBuffer(output, n * mFactor);
+}
 
-    for (int i = 0; i < FACTOR; ++i) {
-        buffer[i] = mAntiImagingFilter.process(buffer[i]);
+template <typename SampleType>
+void Oversampler<SampleType>::downsample(SampleType* output, uint32_t n) {
+    switch (mMethod) {
+        case OversamplingMethod::HalfBandFir:
+            mAlignmentDelay.processBuffer(mBuffers[mOutputBuffer].data(), n * mFactor);
+            downsampleCascade(mStages, output, n);
+            break;
+        case OversamplingMethod::HalfBandIir:
+            downsampleCascade(mAllpassStages, output, n);
+            break;
+        case OversamplingMethod::HermiteBiquad: {
+            // Run anti-aliasing filter over the oversampled samples and keep the last (aligned) one of each frame
+            SampleType* oversampled = mBuffers[mOutputBuffer].data();
+            mAntiAliasFilter.processBuffer(oversampled, n * mFactor);
+            for (uint32_t i = 0; i < n; ++i) {
+                output[i] = oversampled[(i + 1) * mFactor - 1];
+            }
+            break;
+        }
     }
+}
 
-    // Update state for next call
-    mPrevSlope = m1;
-    mPrevInput = x1;
+template <typename SampleType>
+template <typename Stage>
+void Oversampler<SampleType>::downsampleCascade(std::array<Stage, kMaxStages>& stages, SampleType* output, uint32_t n) {
+    if (mNbStages == 0) {
+        std::copy_n(mBuffers[mOutputBuffer].data(), n, output);
+        return;
+    }
 
-    return buffer;
+    // Walk the cascade back from the highest rate, the last stage writing directly to the output.
+    uint32_t stage_size = n * mFactor / 2;
+    uint32_t buffer = mOutputBuffer;
+    for (uint32_t s = mNbStages; s-- > 0;) {
+        SampleType* stage_output = s == 0 ? output : mBuffers[1 - buffer].data();
+        stages[s].downsample(mBuffers[buffer].data(), stage_output, stage_size);
+        buffer = 1 - buffer;
+        stage_size /= 2;
+    }
 }
 
-double Oversampler::downsample() {
-    // Run anti-aliasing filter over the 4 oversampled samples and return the last (aligned) one
-    double y = 0.0;
-    for (int i = 0; i < FACTOR; ++i) {
-        y = mAntiAliasFilter.process(buffer[i]);
+template <typename SampleType>
+bool Oversampler<SampleType>::isQuiet(ScalarOf<SampleType> threshold) const {
+    const auto stage_quiet = [threshold](const auto& stage) { return stage.isQuiet(threshold); };
+    if (mMethod == OversamplingMethod::HalfBandFir) {
+        return mAlignmentDelay.isQuiet(threshold) && std::all_of(mStages.begin(), mStages.begin() + mNbStages, stage_quiet);
+    }
+    if (mMethod == OversamplingMethod::HalfBandIir) {
+        return std::all_of(mAllpassStages.begin(), mAllpassStages.begin() + mNbStages, stage_quiet);
+    }
+
+    if (maxAbs(mPrevInput) >= threshold || maxAbs(mPrevSlope) >= threshold) {
+        return false;
     }
-    return y;
+    return mAntiImagingFilter.isQuiet(threshold) && mAntiAliasFilter.isQuiet(threshold);
 }
 
+template <typename SampleType>
+double Oversampler<SampleType>::latency() const {
+    if (mMethod == OversamplingMethod::HalfBandFir) {
+        // Linear phase stages, plus the alignment delay at the highest rate
+        double delay = mAlignmentDelay.getDelay();
+        for (uint32_t s = 0; s < mNbStages; ++s) {
+            delay += mStages[s].latency() * (mFactor >> s);
+        }
+        return delay / mFactor;
+    }
+    if (mMethod == OversamplingMethod::HalfBandIir) {
+        // Group delay at low frequencies, stage s running at 2^s times the base rate
+        double delay = 0.0;
+        for (uint32_t s = 0; s < mNbStages; ++s) {
+            delay += mAllpassStages[s].latency() / static_cast<double>(1u << s);
+        }
+        return delay;
+    }
+
+    // The interpolation ends on the current input sample, the delay comes from the low-pass filters.
+    return (mAntiImagingFilter.groupDelayAtDc() + mAntiAliasFilter.groupDelayAtDc()) / mFactor;
+}
+
+template <typename SampleType>
+double Oversampler<SampleType>::decaySamples(double ratio) const {
+    if (mMethod == OversamplingMethod::HalfBandFir) {
+        // Finite impulse response, the tail is the latency
+        return latency();
+    }
+    if (mMethod == OversamplingMethod::HalfBandIir) {
+        double decay = 0.0;
+        for (uint32_t s = 0; s < mNbStages; ++s) {
+            decay += mAllpassStages[s].decaySamples(ratio) / static_cast<double>(1u << s);
+        }
+        return decay;
+    }
+
+    return (mAntiImagingFilter.decaySamples(ratio) + mAntiAliasFilter.decaySamples(ratio)) / mFactor;
+}
+
+// Channel groups processed by MultiDisto
+template class Oversampler<Lanes<float, 4>>;
+template class Oversampler<Lanes<double, 2>>;
+
 } // namespace stfefane::dsp
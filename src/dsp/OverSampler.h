@@ -1,33 +1,96 @@
 #pragma once
 
+#include "BiquadBank.h"
 #include "BiquadFilter.h"
+#include "DelayLine.h"
+#include "HalfBandFilter.h"
 #include <array>
+#include <cstdint>
+#include <span>
+#include <string_view>
 
 namespace stfefane::dsp {
 
+static constexpr uint32_t kMaxOversamplingFactor = 16;
+
+// Factors offered to the user, the parameter value n selects 2^n
+static constexpr std::array<std::string_view, 5> kOversamplingFactorNames = {"1x", "2x", "4x", "8x", "16x"};
+
+enum class OversamplingMethod {
+    HalfBandFir,  // Cascade of linear phase polyphase half-band stages
+    HalfBandIir,  // Cascade of polyphase allpass half-band stages, with a low latency
+    HermiteBiquad // Cubic Hermite interpolation with Butterworth anti-aliasing filters
+};
+
+// Methods offered to the user, in the order of OversamplingMethod
+static constexpr std::array<std::string_view, 3> kOversamplingMethodNames = {"Linear Phase", "Low Latency", "Hermite"};
+
+struct OversamplingSetup {
+    uint32_t factor = 4; // Power of two up to kMaxOversamplingFactor
+    OversamplingMethod method = OversamplingMethod::HalfBandFir;
+    bool high_quality = false; // Longer kernels or higher order filters, for offline renders
+};
+
+template <typename SampleType>
 class Oversampler {
 public:
-    static constexpr int FACTOR = 4;
+    static constexpr uint32_t kMaxFactor = kMaxOversamplingFactor;
+    // Base rate samples handled per upsample/downsample call
+    static constexpr uint32_t kMaxBlockSize = 32;
 
-    // Initialize anti-imaging (upsampling) and anti-aliasing (downsampling) filters
-    void setupAntiAliasing(double sampleRate);
+    // Initialize anti-imaging (upsampling) and anti-aliasing (downsampling) filters, allocating their states.
+    void setup(double sampleRate, const OversamplingSetup& setup);
 
-    // Generate 4x-oversampled samples for a single input sample using cubic Hermite interpolation
-    std::array<double, FACTOR>& upsample(double input);
-    // Feed the 4 processed oversampled samples back to base rate with anti-aliasing
-    [[nodiscard]] double downsample();
+    [[nodiscard]] uint32_t getFactor() const { return mFactor; }
+
+    // Generate factor * n oversampled samples from n input samples (n <= kMaxBlockSize).
+    // The returned buffer is processed in place before calling downsample.
+    std::span<SampleType> upsample(const SampleType* input, uint32_t n);
+    // Bring the processed oversampled samples back to n base rate samples with anti-aliasing
+    void downsample(SampleType* output, uint32_t n);
+
+    // True when the interpolation and filter states have decayed below the threshold
+    [[nodiscard]] bool isQuiet(ScalarOf<SampleType> threshold) const;
+    // Delay of the up/down sampling round trip at low frequencies, in base rate samples
+    [[nodiscard]] double latency() const;
+    // Number of base rate samples for the filters to decay by the given ratio
+    [[nodiscard]] double decaySamples(double ratio) const;
 
 private:
-    std::array<double, FACTOR> buffer = {};
+    static constexpr uint32_t kMaxStages = 4; // log2(kMaxFactor)
+    static constexpr uint32_t kMaxSections = 4;
+
+    void upsampleHermite(const SampleType* input, SampleType* output, uint32_t n);
+    template <typename Stage>
+    void upsampleCascade(std::array<Stage, kMaxStages>& stages, const SampleType* input, uint32_t n);
+    template <typename Stage>
+    void downsampleCascade(std::array<Stage, kMaxStages>& stages, SampleType* output, uint32_t n);
+
+    OversamplingMethod mMethod = OversamplingMethod::HalfBandFir;
+    uint32_t mFactor = 4;
+
+    // Ping-pong buffers between the stages, the last one written holds the oversampled block.
+    std::array<std::array<SampleType, kMaxBlockSize * kMaxFactor>, 2> mBuffers = {};
+    uint32_t mOutputBuffer = 0;
+
+    // Half-band cascades, the first stage runs at the lowest rate
+    uint32_t mNbStages = 0;
+    std::array<HalfBandStage<SampleType>, kMaxStages> mStages;
+    std::array<HalfBandAllpassStage<SampleType>, kMaxStages> mAllpassStages;
+    // Delays the oversampled signal so the round trip latency is a whole number of base rate samples
+    DelayLine<SampleType> mAlignmentDelay;
 
-    // State for interpolation between previous and current input samples
-    double mPrevInput = 0.0;
-    double mPrevSlope = 0.0;
+    // Hermite interpolation between previous and current input samples
+    uint32_t mNbSections = 1;
+    // Hermite basis weights {h00, h10, h01, h11} of each oversampled position
+    std::array<std::array<ScalarOf<SampleType>, 4>, kMaxFactor> mHermiteWeights = {};
+    SampleType mPrevInput = 0;
+    SampleType mPrevSlope = 0;
 
-    // Anti-imaging filter applied in the upsampled domain (fs * FACTOR)
-    BiquadFilter mAntiImagingFilter;
-    // Anti-aliasing filter applied before decimation (also in fs * FACTOR)
-    BiquadFilter mAntiAliasFilter;
+    // Anti-imaging filter applied in the upsampled domain (fs * factor), as cascaded 2nd order sections
+    BiquadBank<SampleType, kMaxSections> mAntiImagingFilter;
+    // Anti-aliasing filter applied before decimation (also in fs * factor)
+    BiquadBank<SampleType, kMaxSections> mAntiAliasFilter;
 };
 
 }
\ No newline at end of file
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <type_traits>
+
+namespace stfefane::dsp {
+
+/**
+ * Fixed size group of values processed together, one lane per channel (SoA layout).
+ * The operators are plain loops over the lanes, which compilers turn into a single
+ * SSE2/AVX/NEON instruction when the group fits a register (2 doubles, 4 floats...).
+ * A scalar converts implicitly to a Lanes where all the lanes share the same value,
+ * so the DSP code can be written once for both scalars and lane groups.
+ */
+template <typename T, std::size_t N>
+struct alignas(sizeof(T) * N) Lanes {
+    static constexpr std::size_t kSize = N;
+
+    T v[N] = {};
+
+    constexpr Lanes() = default;
+    constexpr Lanes(T value) {
+        for (std::size_t i = 0; i < N; ++i) {
+            v[i] = value;
+        }
+    }
+
+    constexpr T& operator[](std::size_t i) { return v[i]; }
+    constexpr const T& operator[](std::size_t i) const { return v[i]; }
+
+#define STFEFANE_LANES_OPERATOR(op, assign_op)                                                                               \
+    constexpr Lanes& operator assign_op(const Lanes& o) {                                                                    \
+        for (std::size_t i = 0; i < N; ++i) {                                                                                \
+            v[i] assign_op o.v[i];                                                                                           \
+        }                                                                                                                    \
+        return *this;                                                                                                        \
+    }                                                                                                                        \
+    friend constexpr Lanes operator op(Lanes a, const Lanes& b) {                                                            \
+        a assign_op b;                                                                                                       \
+        return a;                                                                                                            \
+    }                                                                                                                        \
+    friend constexpr Lanes operator op(Lanes a, T b) {                                                                       \
+        a assign_op Lanes(b);                                                                                                \
+        return a;                                                                                                            \
+    }                                                                                                                        \
+    friend constexpr Lanes operator op(T a, const Lanes& b) {                                                                \
+        Lanes r(a);                                                                                                          \
+        r assign_op b;                                                                                                       \
+        return r;                                                                                                            \
+    }
+
+    STFEFANE_LANES_OPERATOR(+, +=)
+    STFEFANE_LANES_OPERATOR(-, -=)
+    STFEFANE_LANES_OPERATOR(*, *=)
+    STFEFANE_LANES_OPERATOR(/, /=)
+#undef STFEFANE_LANES_OPERATOR
+
+    constexpr Lanes operator-() const {
+        Lanes r;
+        for (std::size_t i = 0; i < N; ++i) {
+            r.v[i] = -v[i];
+        }
+        return r;
+    }
+};
+
+template <typename T>
+struct LaneTraits {
+    using Scalar = T;
+    static constexpr std::size_t kSize = 1;
+};
+
+template <typename T, std::size_t N>
+struct LaneTraits<Lanes<T, N>> {
+    using Scalar = T;
+    static constexpr std::size_t kSize = N;
+};
+
+// Underlying floating point type of a scalar or a lane group
+template <typename T>
+using ScalarOf = typename LaneTraits<T>::Scalar;
+
+template <typename T>
+constexpr std::size_t kLanesOf = LaneTraits<T>::kSize;
+
+// Apply a scalar function to each lane of a group
+template <typename T, std::size_t N, typename F>
+inline Lanes<T, N> map(const Lanes<T, N>& x, F&& f) {
+    Lanes<T, N> r;
+    for (std::size_t i = 0; i < N; ++i) {
+        r.v[i] = f(x.v[i]);
+    }
+    return r;
+}
+
+template <typename T, typename F>
+    requires std::is_floating_point_v<T>
+inline T map(T x, F&& f) {
+    return f(x);
+}
+
+// Largest magnitude across the lanes of a group
+template <typename T, std::size_t N>
+inline T maxAbs(const Lanes<T, N>& x) {
+    T m = 0;
+    for (std::size_t i = 0; i < N; ++i) {
+        m = std::max(m, std::fabs(x.v[i]));
+    }
+    return m;
+}
+
+template <typename T>
+    requires std::is_floating_point_v<T>
+inline T maxAbs(T x) {
+    return std::fabs(x);
+}
+
+} // namespace stfefane::dsp
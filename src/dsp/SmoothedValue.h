@@ -2,51 +2,105 @@
 
 #include "utils/Utils.h"
 #include <algorithm>
+#include <cmath>
+#include <cstdint>
 
 namespace stfefane::dsp {
 
 /**
- * Tiny wrapper around a double value to avoid jumps when updating it
+ * Tiny wrapper around a floating point value to avoid jumps when updating it.
+ * A new target starts a linear ramp of fixed duration from the current value. The ramp is rendered a block at a time,
+ * the targets being picked up at the start of each block.
  */
+template <typename SampleType>
 struct SmoothedValue {
-    double mSampleRate = 44100.0;
-    double mCoeff = 0.0;
-    double mProcessedValue = 0.0;
-    double mTargetValue = 0.0;
+    uint32_t mRampLength = 1;
+    uint32_t mRemaining = 0;
+    SampleType mStep = 0;
+    SampleType mProcessedValue = 0;
+    SampleType mTargetValue = 0;
+    // Target of the ramp in progress, a different mTargetValue restarts the ramp
+    SampleType mRampTarget = 0;
 
     void setup(double sr, double ms) {
-        mSampleRate = sr;
-        const double tau = std::max(1e-6, ms * 1e-3);
-        mCoeff = 1.0 - std::exp(-1.0 / (tau * mSampleRate));
+        mRampLength = std::max<uint32_t>(1, static_cast<uint32_t>(std::lround(ms * 1e-3 * sr)));
     }
 
-    void process() {
-        if (utils::almostEqual(mProcessedValue, mTargetValue)) {
-            return;
+    // Jump to the target, for the start of the processing
+    void snap() {
+        mProcessedValue = mTargetValue;
+        mRampTarget = mTargetValue;
+        mRemaining = 0;
+    }
+
+    // Write the next n values, the linear ramp being a plain loop that vectorises
+    void renderRamp(SampleType* values, uint32_t n) {
+        const uint32_t ramp = advance(n);
+        const SampleType start = mProcessedValue;
+        for (uint32_t i = 0; i < ramp; ++i) {
+            values[i] = start + mStep * static_cast<SampleType>(i + 1);
+        }
+        finishRamp(start, ramp);
+        std::fill(values + ramp, values + n, mProcessedValue);
+    }
+
+    // Ramp to a new target over the next n samples instead of the default duration.
+    // Values that change at every block, like the host modulation, then reach each target by the end of the block.
+    void rampOver(uint32_t n) {
+        if (mTargetValue != mRampTarget) {
+            startRamp(std::max<uint32_t>(1, n));
         }
-        mProcessedValue += mCoeff * (mTargetValue - mProcessedValue);
     }
 
-    // Allows to use arithmetic operations with a regular double.
+    // Move n samples forward without writing the values
+    void skip(uint32_t n) { finishRamp(mProcessedValue, advance(n)); }
+
+    // True when the value has reached its target and won't move anymore
+    [[nodiscard]] bool isSettled() const {
+        return mRemaining == 0 && mProcessedValue == mTargetValue;
+    }
+
+    // Allows to use arithmetic operations with a regular value.
     // Voluntarily not made explicit to allow simple automatic conversion.
-    operator double() const {
+    operator SampleType() const {
         return mProcessedValue;
     }
 
     // Set the target with a simple value assignment
-    SmoothedValue& operator=(double v) {
+    SmoothedValue& operator=(SampleType v) {
         mTargetValue = v;
         return *this;
     }
 
-    // Simple operator to compare with other double values
-    bool operator==(double v) const {
+    // Simple operator to compare with other values
+    bool operator==(SampleType v) const {
         return mProcessedValue == v;
     }
 
     bool operator==(const SmoothedValue& v) const {
         return mProcessedValue == v.mProcessedValue;
     }
+
+private:
+    // Starts a new ramp if the target changed, returns how many of the next n samples are ramping.
+    uint32_t advance(uint32_t n) {
+        if (mTargetValue != mRampTarget) {
+            startRamp(mRampLength);
+        }
+        return std::min(n, mRemaining);
+    }
+
+    void startRamp(uint32_t length) {
+        mRampTarget = mTargetValue;
+        mRemaining = length;
+        mStep = (mTargetValue - mProcessedValue) / static_cast<SampleType>(length);
+    }
+
+    void finishRamp(SampleType start, uint32_t ramp) {
+        mRemaining -= ramp;
+        // The last step lands exactly on the target, whatever the rounding of the increments.
+        mProcessedValue = mRemaining == 0 ? mRampTarget : start + mStep * static_cast<SampleType>(ramp);
+    }
 };
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,290 @@
+#pragma once
+
+#include "BiquadBank.h"
+#include "BiquadFilter.h"
+#include "FastMath.h"
+#include "Simd.h"
+#include "utils/Utils.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <numbers>
+#include <string_view>
+
+namespace stfefane::dsp {
+
+enum class FilterTopology { Biquad, StateVariable };
+
+// Topologies offered to the user, in the order of FilterTopology
+static constexpr std::array<std::string_view, 2> kFilterTopologyNames = {"Biquad", "State Variable"};
+
+// Coefficients of the SVF: prewarped frequency g, damping k and the mix of the input, bandpass and lowpass outputs
+struct SvfCoefficients {
+    double g = 0.0;
+    double k = 1.0;
+    double m0 = 1.0;
+    double m1 = 0.0;
+    double m2 = 0.0;
+    // Factor of tan(pi * f / fs) in g, the shelves moving it by sqrt(A) to keep the RBJ definition of their frequency
+    double freqScale = 1.0;
+};
+
+// SVF design giving the responses of the RBJ biquads, without any libm call for the frequency and gain.
+// None, or an invalid sample rate, gives a bypass.
+[[nodiscard]] inline SvfCoefficients designSvf(FilterType type, double sampleRate, double freq, double q = 0.707,
+                                               double gainDb = 0.0) {
+    if (type == FilterType::None || sampleRate <= 0.0) {
+        return {};
+    }
+
+    // For Q <= 0 treat as minimum Q
+    const double k = 1.0 / std::max(q, 1e-6);
+    // for shelving/peak, 10^(gainDb / 40)
+    const double A = gainDb == 0.0 ? 1.0 : fastmath::exp(gainDb * (std::numbers::ln10 / 40.0));
+    SvfCoefficients c;
+    c.k = k;
+    c.m0 = 0.0;
+
+    switch (type) {
+    case FilterType::LowPass:
+        c.m2 = 1;
+        break;
+    case FilterType::HighPass:
+        c.m0 = 1;
+        c.m1 = -k;
+        c.m2 = -1;
+        break;
+    case FilterType::BandPass:
+        c.m1 = 1; // constant skirt gain, peak gain = Q
+        break;
+    case FilterType::Notch:
+        c.m0 = 1;
+        c.m1 = -k;
+        break;
+    case FilterType::AllPass:
+        c.m0 = 1;
+        c.m1 = -2 * k;
+        break;
+    case FilterType::Peak:
+        c.k = k / A;
+        c.m0 = 1;
+        c.m1 = c.k * (A * A - 1);
+        break;
+    case FilterType::LowShelf:
+        c.freqScale = 1.0 / std::sqrt(A);
+        c.m0 = 1;
+        c.m1 = k * (A - 1);
+        c.m2 = A * A - 1;
+        break;
+    case FilterType::HighShelf:
+        c.freqScale = std::sqrt(A);
+        c.m0 = A * A;
+        c.m1 = k * (1 - A) * A;
+        c.m2 = 1 - A * A;
+        break;
+    case FilterType::None:
+        // handled earlier
+        break;
+    }
+
+    c.g = c.freqScale * fastmath::tan(utils::kPI_64 * detail::normalizedFrequency(sampleRate, freq));
+    return c;
+}
+
+// State variable filter discretized with the topology-preserving transform (trapezoidal integrators),
+// following Andrew Simper's "Solving the continuous SVF equations using trapezoidal integration".
+//
+// Implementation notes:
+// - Offers the same responses as BiquadFilter, mixed from the lowpass, bandpass and highpass outputs of the SVF.
+//   For static settings the response is the one of the RBJ biquad.
+// - The state holds the integrator values rather than past outputs, so it stays valid when the coefficients change
+//   at every sample: cutoff sweeps don't zipper or blow up like a direct form.
+// - Changing the frequency only costs a rational tan approximation and a division, see fastmath::tan.
+// - SampleType can be a Lanes group, in which case all lanes share the coefficients and run in parallel.
+template <typename SampleType>
+class SvfFilter {
+public:
+    using Type = FilterType;
+    using Scalar = ScalarOf<SampleType>;
+
+    SvfFilter() = default;
+
+    explicit SvfFilter(Type type, double freq, double q = 0.707, double gainDb = 0.0)
+        : mType(type), mFreq(freq), mQ(q), mGainDb(gainDb) {
+        updateCoefficients();
+    }
+
+    void setup(Type type, double freq, double q = 0.707, double gainDb = 0.0) {
+        mType = type;
+        mFreq = freq;
+        mQ = q;
+        mGainDb = gainDb;
+        reset();
+        updateCoefficients();
+    }
+
+    void setSampleRate(double sampleRate) {
+        mSampleRate = sampleRate;
+        updateCoefficients();
+    }
+
+    void setType(Type type) {
+        mType = type;
+        updateCoefficients();
+    }
+
+    void setFreq(double freq) {
+        mFreq = freq;
+        updateFrequency();
+    }
+
+    void setQ(double q) {
+        mQ = q;
+        updateCoefficients();
+    }
+
+    void setGainDb(double gainDb) {
+        mGainDb = gainDb;
+        updateCoefficients();
+    }
+
+    [[nodiscard]] double getSampleRate() const { return mSampleRate; }
+    [[nodiscard]] Type getType() const { return mType; }
+    [[nodiscard]] double getFreq() const { return mFreq; }
+    [[nodiscard]] double getQ() const { return mQ; }
+    [[nodiscard]] double getGainDb() const { return mGainDb; }
+
+    void reset() {
+        mIc1 = SampleType(0);
+        mIc2 = SampleType(0);
+    }
+
+    // Process a single sample
+    inline SampleType process(SampleType x) { return mActive ? tick(x, mA1, mA2, mA3) : x; }
+
+    // Process a buffer in-place
+    void processBuffer(SampleType* samples, std::size_t count) {
+        if (!mActive) {
+            return;
+        }
+        for (std::size_t i = 0; i < count; ++i) {
+            samples[i] = tick(samples[i], mA1, mA2, mA3);
+        }
+    }
+
+    // Process a buffer in-place with a cutoff frequency (in Hz) for each sample.
+    // The frequency given to setFreq is left untouched, and used again by the next processBuffer without frequencies.
+    void processBuffer(SampleType* samples, const Scalar* freq, std::size_t count) {
+        if (!mActive) {
+            return;
+        }
+        for (std::size_t i = 0; i < count; ++i) {
+            const Scalar g = prewarp(freq[i]);
+            const Scalar a1 = Scalar(1) / (Scalar(1) + g * (g + mK));
+            const Scalar a2 = g * a1;
+            samples[i] = tick(samples[i], a1, a2, g * a2);
+        }
+    }
+
+    // Process a buffer in-place with the coefficients {g, k, m0, m1, m2} of each sample, the ones of the filter
+    // being left untouched. Any positive g and k keep the filter stable, so the interpolated coefficients do too.
+    void processBuffer(SampleType* samples, const CoefficientRamp<Scalar>& coefficients, std::size_t count) {
+        const auto [g, k, m0, m1, m2] = coefficients;
+        for (std::size_t i = 0; i < count; ++i) {
+            const Scalar a1 = Scalar(1) / (Scalar(1) + g[i] * (g[i] + k[i]));
+            const Scalar a2 = g[i] * a1;
+            const SampleType v0 = samples[i];
+            const SampleType v3 = v0 - mIc2;
+            const SampleType v1 = a1 * mIc1 + a2 * v3;
+            const SampleType v2 = mIc2 + a2 * mIc1 + g[i] * a2 * v3;
+            mIc1 = Scalar(2) * v1 - mIc1;
+            mIc2 = Scalar(2) * v2 - mIc2;
+            samples[i] = m0[i] * v0 + m1[i] * v1 + m2[i] * v2;
+        }
+    }
+
+    // True when the filter state has decayed below the threshold on every lane
+    [[nodiscard]] bool isQuiet(Scalar threshold) const { return maxAbs(mIc1) < threshold && maxAbs(mIc2) < threshold; }
+
+    // Group delay at DC in samples, the same as the equivalent biquad
+    [[nodiscard]] double groupDelayAtDc() const { return equivalentBiquad().groupDelayAtDc(); }
+
+    // Number of samples for the impulse response to decay by the given ratio, the same as the equivalent biquad
+    [[nodiscard]] double decaySamples(double ratio) const { return equivalentBiquad().decaySamples(ratio); }
+
+    // Recompute the gain dependent mixing coefficients and the frequency dependent ones
+    void updateCoefficients() {
+        mActive = mType != Type::None && mSampleRate > 0.0;
+        const SvfCoefficients c = designSvf(mType, mSampleRate, mFreq, mQ, mGainDb);
+        mPiOverSampleRate = static_cast<Scalar>(utils::kPI_64 / mSampleRate);
+        mMaxFreq = static_cast<Scalar>(0.99 * 0.5 * mSampleRate);
+        mFreqScale = static_cast<Scalar>(c.freqScale);
+        mK = static_cast<Scalar>(c.k);
+        mM0 = static_cast<Scalar>(c.m0);
+        mM1 = static_cast<Scalar>(c.m1);
+        mM2 = static_cast<Scalar>(c.m2);
+        setG(static_cast<Scalar>(c.g));
+    }
+
+private:
+    // g = tan(pi * f / fs) * freqScale, see SvfCoefficients. The frequency is clamped between 1Hz and 0.99 * Nyquist like BiquadFilter.
+    [[nodiscard]] inline Scalar prewarp(Scalar freq) const {
+        return mFreqScale * fastmath::tan(std::clamp(freq, Scalar(1), mMaxFreq) * mPiOverSampleRate);
+    }
+
+    void updateFrequency() {
+        if (mActive) {
+            setG(prewarp(static_cast<Scalar>(mFreq)));
+        }
+    }
+
+    void setG(Scalar g) {
+        mG = g;
+        mA1 = Scalar(1) / (Scalar(1) + g * (g + mK));
+        mA2 = g * mA1;
+        mA3 = g * mA2;
+    }
+
+    inline SampleType tick(SampleType v0, Scalar a1, Scalar a2, Scalar a3) {
+        const SampleType v3 = v0 - mIc2;
+        const SampleType v1 = a1 * mIc1 + a2 * v3;
+        const SampleType v2 = mIc2 + a2 * mIc1 + a3 * v3;
+        // Denormals are flushed by the DenormalGuard set around the processing.
+        mIc1 = Scalar(2) * v1 - mIc1;
+        mIc2 = Scalar(2) * v2 - mIc2;
+        return mM0 * v0 + mM1 * v1 + mM2 * v2;
+    }
+
+    // Bilinear transform of the analog prototype (m0 s^2 + (m0 k + m1) s + m0 + m2) / (s^2 + k s + 1) with s = (1/g)(1 - z^-1)/(1 + z^-1)
+    [[nodiscard]] BiquadCoefficients equivalentBiquad() const {
+        if (!mActive) {
+            return {};
+        }
+        const double g = mG;
+        const double k = mK;
+        const double n2 = mM0;
+        const double n1 = mM0 * k + mM1;
+        const double n0 = mM0 + mM2;
+        const double inv_a0 = 1.0 / (1.0 + k * g + g * g);
+        return {(n2 + n1 * g + n0 * g * g) * inv_a0, 2.0 * (n0 * g * g - n2) * inv_a0, (n2 - n1 * g + n0 * g * g) * inv_a0,
+                2.0 * (g * g - 1.0) * inv_a0, (1.0 - k * g + g * g) * inv_a0};
+    }
+
+    // Damping, mixing and integrator coefficients
+    bool mActive = false;
+    Scalar mPiOverSampleRate{0}, mMaxFreq{1}, mFreqScale{1};
+    Scalar mK{1}, mM0{1}, mM1{0}, mM2{0};
+    Scalar mG{0}, mA1{1}, mA2{0}, mA3{0};
+
+    // Integrator states
+    SampleType mIc1{0}, mIc2{0};
+
+    // Parameters
+    Type mType{Type::None};
+    double mSampleRate{44100.0};
+    double mFreq{1000.0};
+    double mQ{0.707};
+    double mGainDb{0.0};
+};
+
+} // namespace stfefane::dsp
@@ -1,79 +1,208 @@
 #pragma once
 
 #include <algorithm>
-#include <iomanip>
-#include <ios>
-#include <sstream>
+#include <array>
+#include <cctype>
+#include <clap/ext/params.h>
+#include <cmath>
+#include <optional>
+#include <span>
 #include <string>
-#include <vector>
+#include <string_view>
 
 #include "params/ValueMapping.h"
 #include "utils/Utils.h"
 
 namespace stfefane::params {
 
+enum class ValueKind { Continuous, Stepped, Boolean };
+
+static constexpr std::array<std::string_view, 2> kBooleanSteps = {"Off", "On"};
+
+// Range and display of a parameter value.
+// The kinds are a closed set handled with plain branches, and the type only refers to constant data,
+// so parameters hold it by value and nothing is allocated.
+// The conversions to and from text don't allocate or throw either, the host calling them a lot from any thread.
 struct ParamValueType {
-    ParamValueType(double min, double max, double defaultVal, std::string unit = std::string(), MappingType mapping = MappingType::Linear)
-        : mMapping(mapping, min, max), mDefault(mMapping.normalize(defaultVal)), mUnit(std::move(unit)) {}
-    virtual ~ParamValueType() = default;
+    // Enough for any value with its unit, and the longest step name
+    static constexpr size_t kMaxTextSize = 64;
 
+    ValueKind mKind = ValueKind::Continuous;
     ValueMapping mMapping;
+    // Plain default value, the index of the step for stepped values
     double mDefault = 0.;
-    std::string mUnit;
+    std::string_view mUnit;
+    // Names of the steps, empty for continuous values
+    std::span<const std::string_view> mSteps;
     uint32_t mFlags = CLAP_PARAM_IS_AUTOMATABLE;
+    // Displays thousands and millions with a k or M prefix before the unit, as in 1.20 kHz
+    bool mPrefixes = false;
 
-    [[nodiscard]] virtual std::string toText(double value, bool unit = true) const {
-        std::ostringstream os;
-        os << std::fixed << std::setprecision(2) << denormalizedValue(value);
-        if (unit) {
-            os << mUnit;
-        }
-        return os.str();
+    static constexpr ParamValueType continuous(double min, double max, double default_value,
+                                               std::string_view unit = {}, MappingType mapping = MappingType::Linear) {
+        return {.mKind = ValueKind::Continuous,
+                .mMapping = ValueMapping(mapping, min, max),
+                .mDefault = default_value,
+                .mUnit = unit,
+                .mSteps = {},
+                .mFlags = CLAP_PARAM_IS_AUTOMATABLE,
+                .mPrefixes = false};
     }
 
-    [[nodiscard]] virtual double toValue(const std::string& text) const {
-        return normalizedValue(utils::stringToDouble(text));
+    // Settings that can't be automated don't get the CLAP_PARAM_IS_AUTOMATABLE flag.
+    static constexpr ParamValueType stepped(std::span<const std::string_view> steps, double default_index,
+                                            bool automatable = true) {
+        return {.mKind = ValueKind::Stepped,
+                .mMapping = ValueMapping(MappingType::Linear, 0., static_cast<double>(steps.size() - 1)),
+                .mDefault = default_index,
+                .mUnit = {},
+                .mSteps = steps,
+                .mFlags = static_cast<uint32_t>(automatable ? CLAP_PARAM_IS_AUTOMATABLE | CLAP_PARAM_IS_STEPPED
+                                                            : CLAP_PARAM_IS_STEPPED),
+                .mPrefixes = false};
     }
 
-    [[nodiscard]] double denormalizedValue(double value) const {
-        return mMapping.denormalize(value);
+    static constexpr ParamValueType boolean(bool default_value) {
+        auto value_type = stepped(kBooleanSteps, default_value ? 1. : 0.);
+        value_type.mKind = ValueKind::Boolean;
+        return value_type;
     }
 
-    [[nodiscard]] double normalizedValue(double value) const {
-        return mMapping.normalize(value);
+    // Same value, that the host can also modulate around the value set by the automation or the user.
+    [[nodiscard]] constexpr ParamValueType modulatable() const {
+        auto value_type = *this;
+        value_type.mFlags = static_cast<uint32_t>(mFlags | CLAP_PARAM_IS_MODULATABLE);
+        return value_type;
     }
-};
 
-struct SteppedValueType : public ParamValueType {
-    explicit SteppedValueType(std::vector<std::string>&& values, double defaultVal)
-        : ParamValueType(0., static_cast<double>(values.size() - 1), defaultVal)
-        , mValues(std::move(values)) {
-        mDefault = defaultVal;
-        mFlags = CLAP_PARAM_IS_AUTOMATABLE | CLAP_PARAM_IS_STEPPED;
+    [[nodiscard]] constexpr ParamValueType withPrefixes() const {
+        auto value_type = *this;
+        value_type.mPrefixes = true;
+        return value_type;
     }
 
-    [[nodiscard]] std::string toText(double value, bool unit) const override {
-        const auto index = static_cast<size_t>(value);
-        if (index >= mValues.size()) {
-            return "INVALID INDEX";
+    [[nodiscard]] constexpr bool isStepped() const noexcept { return mKind != ValueKind::Continuous; }
+
+    [[nodiscard]] constexpr size_t nbSteps() const noexcept { return isStepped() ? mSteps.size() : 1; }
+
+    // Default value as stored by the parameter: normalized, or the index of the step
+    [[nodiscard]] double storedDefault() const { return isStepped() ? mDefault : normalizedValue(mDefault); }
+
+    // Writes the text of value as a null terminated string of up to size bytes in display,
+    // false if it doesn't fit or the step index is invalid.
+    [[nodiscard]] bool toText(double value, char* display, size_t size, bool unit = true) const noexcept {
+        if (display == nullptr || size == 0) {
+            return false;
+        }
+        char* out = display;
+        char* const last = display + size - 1; // Room for the null terminator
+        const auto append = [&](std::string_view text) {
+            if (out == nullptr || static_cast<size_t>(last - out) < text.size()) {
+                out = nullptr;
+                return;
+            }
+            out = std::copy(text.begin(), text.end(), out);
+        };
+
+        if (isStepped()) {
+            // Checked before the cast, converting a negative, NaN or too large value to an index is undefined.
+            if (!(value >= 0. && value < static_cast<double>(mSteps.size()))) {
+                return false;
+            }
+            append(mSteps[static_cast<size_t>(value)]);
+        } else {
+            double plain = denormalizedValue(value);
+            std::string_view prefix;
+            if (mPrefixes && std::abs(plain) >= 1e6) {
+                plain /= 1e6;
+                prefix = "M";
+            } else if (mPrefixes && std::abs(plain) >= 1e3) {
+                plain /= 1e3;
+                prefix = "k";
+            }
+            out = utils::doubleToString(out, last, plain, 2);
+            // The spaces the unit starts with go before the prefix.
+            const auto spaces = unit ? std::min(mUnit.find_first_not_of(' '), mUnit.size()) : 0;
+            append(mUnit.substr(0, spaces));
+            append(prefix);
+            if (unit) {
+                append(mUnit.substr(spaces));
+            }
         }
-        return mValues[index];
+
+        if (out == nullptr) {
+            display[0] = '\0';
+            return false;
+        }
+        *out = '\0';
+        return true;
+    }
+
+    // Text of value, for the display of the editor
+    [[nodiscard]] std::string toText(double value, bool unit = true) const {
+        std::array<char, kMaxTextSize> buffer;
+        return toText(value, buffer.data(), buffer.size(), unit) ? std::string(buffer.data()) : std::string("INVALID INDEX");
     }
 
-    [[nodiscard]] double toValue(const std::string& text) const override {
-        if (const auto it = std::ranges::find(mValues, text); it != mValues.end()) {
-            const auto index = std::distance(mValues.begin(), it);
-            return static_cast<double>(index);
+    // Value of the text in the stored range, nullopt when it's not a step name or a number, optionally followed by
+    // a k or M prefix and the unit. Spaces and the case of the unit don't matter.
+    [[nodiscard]] std::optional<double> toValue(std::string_view text) const noexcept {
+        text = trim(text);
+        if (isStepped()) {
+            if (const auto it = std::ranges::find(mSteps, text); it != mSteps.end()) {
+                return static_cast<double>(std::distance(mSteps.begin(), it));
+            }
+            return std::nullopt;
         }
-        return 0.;
+
+        size_t used = 0;
+        auto plain = utils::stringToDouble(text, &used);
+        if (!plain || !std::isfinite(*plain)) {
+            return std::nullopt;
+        }
+        auto rest = trim(text.substr(used));
+        const auto unit = trim(mUnit);
+        if (!rest.empty() && !startsWithUnit(rest, unit)) {
+            if (rest.front() == 'k' || rest.front() == 'K') {
+                *plain *= 1e3;
+                rest = trim(rest.substr(1));
+            } else if (rest.front() == 'M') {
+                *plain *= 1e6;
+                rest = trim(rest.substr(1));
+            }
+        }
+        if (startsWithUnit(rest, unit)) {
+            rest = trim(rest.substr(unit.size()));
+        }
+        if (!rest.empty()) {
+            return std::nullopt;
+        }
+        return normalizedValue(*plain);
     }
 
-    const std::vector<std::string> mValues;
-};
+    [[nodiscard]] double denormalizedValue(double value) const {
+        return mMapping.denormalize(value);
+    }
 
-struct BooleanValueType final : SteppedValueType {
-    explicit BooleanValueType(bool defaultVal)
-        : SteppedValueType({ "Off", "On" }, defaultVal) {}
+    [[nodiscard]] double normalizedValue(double value) const {
+        return mMapping.normalize(value);
+    }
+
+private:
+    [[nodiscard]] static constexpr std::string_view trim(std::string_view text) noexcept {
+        const auto first = text.find_first_not_of(' ');
+        if (first == std::string_view::npos) {
+            return {};
+        }
+        return text.substr(first, text.find_last_not_of(' ') - first + 1);
+    }
+
+    [[nodiscard]] static bool startsWithUnit(std::string_view text, std::string_view unit) noexcept {
+        return !unit.empty() && text.size() >= unit.size()
+            && std::equal(unit.begin(), unit.end(), text.begin(), [](char a, char b) {
+                   return std::tolower(static_cast<unsigned char>(a)) == std::tolower(static_cast<unsigned char>(b));
+               });
+    }
 };
 
-}
\ No newline at end of file
+}
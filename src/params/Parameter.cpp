@@ -8,20 +8,25 @@
 
 namespace stfefane::params {
 
-Parameter::Parameter(clap_id id, const std::string& name, std::unique_ptr<ParamValueType> value_type, size_t index)
+Parameter::Parameter(clap_id id, std::string_view name, const ParamValueType& value_type, size_t index,
+                     ParameterChanges& changes)
     : mIndex(index)
     , mInfo {
         .id = id,
-        .flags = value_type->mFlags,
+        .flags = value_type.mFlags,
         .cookie = this,
+        .name = {},
+        .module = {},
         .min_value = 0.,
         .max_value = 1.,
-        .default_value = value_type->mDefault,
+        .default_value = value_type.storedDefault(),
     }
-    , mValue(value_type->mDefault)
-    , mValueType(std::move(value_type))
+    , mValue(mInfo.default_value)
+    , mChanges(changes)
+    , mValueType(value_type)
+    , mNbSteps(value_type.nbSteps())
 {
-    snprintf(mInfo.name, sizeof(mInfo.name), "%s", name.c_str());
+    snprintf(mInfo.name, sizeof(mInfo.name), "%.*s", static_cast<int>(name.size()), name.data());
     LOG_INFO("param", "Parameter {} init with default_value {}", name, mInfo.default_value);
     if (isStepped()) {
         mInfo.max_value = static_cast<double>(nbSteps() - 1);
@@ -32,12 +37,15 @@ void Parameter::setValue(double value) {
     if (isStepped()) {
         value = std::round(value);
     }
-    mValue.store(value, std::memory_order_relaxed);
+    {
+        const ParameterChanges::Scope change(mChanges);
+        mValue.store(value, std::memory_order_relaxed);
+    }
     notifyAllListeners();
 }
 
 void Parameter::reset() {
-    setValue(mValueType->mDefault);
+    setValue(mInfo.default_value);
 }
 
 void Parameter::notifyAllListeners() const noexcept {
@@ -46,17 +54,6 @@ void Parameter::notifyAllListeners() const noexcept {
     }
 }
 
-size_t Parameter::nbSteps() const noexcept {
-    if (!isStepped()) {
-        return 1;
-    }
-    if (const auto* stepped_param = dynamic_cast<SteppedValueType*>(mValueType.get()); stepped_param) {
-        return stepped_param->mValues.size();
-    }
-
-    return 1;
-}
-
 void Parameter::addListener(IParameterListener* listener) {
     if (std::ranges::find(mListeners, listener) == mListeners.end()) {
         mListeners.push_back(listener);
@@ -1,11 +1,12 @@
 #pragma once
 
 #include <atomic>
-#include <memory>
+#include <string_view>
 #include <vector>
 #include <clap/ext/params.h>
 
 #include "ParamValueType.h"
+#include "ParameterChanges.h"
 
 namespace stfefane::params {
 
@@ -13,7 +14,8 @@ class IParameterListener;
 
 class Parameter {
 public:
-    explicit Parameter(clap_id id, const std::string& name, std::unique_ptr<ParamValueType> value_type, size_t index);
+    explicit Parameter(clap_id id, std::string_view name, const ParamValueType& value_type, size_t index,
+                       ParameterChanges& changes);
     Parameter() = delete;
     Parameter(const Parameter &) = delete;
     Parameter(Parameter &&) = delete;
@@ -26,10 +28,10 @@ public:
     void notifyAllListeners() const noexcept;
 
     [[nodiscard]] const clap_param_info& getInfo() const noexcept { return mInfo; }
-    [[nodiscard]] const ParamValueType& getValueType() const noexcept { return *mValueType; }
+    [[nodiscard]] const ParamValueType& getValueType() const noexcept { return mValueType; }
 
     [[nodiscard]] bool isStepped() const noexcept { return mInfo.flags & CLAP_PARAM_IS_STEPPED; }
-    [[nodiscard]] size_t nbSteps() const noexcept;
+    [[nodiscard]] size_t nbSteps() const noexcept { return mNbSteps; }
 
     void addListener(IParameterListener* listener);
     void removeListener(IParameterListener* listener);
@@ -38,8 +40,11 @@ private:
     size_t mIndex = -1;
     clap_param_info mInfo;
     std::atomic<double> mValue = 0.;
+    // Shared by the parameters of the plugin, to read them all at once on the audio thread
+    ParameterChanges& mChanges;
 
-    std::unique_ptr<ParamValueType> mValueType;
+    ParamValueType mValueType;
+    size_t mNbSteps = 1;
 
     std::vector<IParameterListener*> mListeners;
 };
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <optional>
+
+namespace stfefane::params {
+
+/**
+ * Tells whether parameter values read from another thread belong together, without any lock.
+ * Every write happens in a Scope, which counts as one change when it ends. A reader takes the version before and after
+ * reading the values, which are consistent when both versions are valid and the same.
+ * Scopes can be nested or run concurrently on several threads, a preset load wraps all its writes in a single one.
+ */
+class ParameterChanges {
+public:
+    class Scope {
+    public:
+        explicit Scope(ParameterChanges& changes) : mChanges(changes) {
+            mChanges.mWriters.fetch_add(1, std::memory_order_relaxed);
+            // A reader seeing any of the values written next also sees the write in progress.
+            std::atomic_thread_fence(std::memory_order_release);
+        }
+        ~Scope() {
+            mChanges.mVersion.fetch_add(1, std::memory_order_release);
+            mChanges.mWriters.fetch_sub(1, std::memory_order_release);
+        }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        ParameterChanges& mChanges;
+    };
+
+    // Version to take before reading the values, none while a write is in progress.
+    [[nodiscard]] std::optional<uint64_t> beginRead() const noexcept {
+        if (mWriters.load(std::memory_order_acquire) != 0) {
+            return std::nullopt;
+        }
+        return mVersion.load(std::memory_order_acquire);
+    }
+
+    // True when the values read since beginRead gave version belong together.
+    [[nodiscard]] bool endRead(uint64_t version) const noexcept {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return mWriters.load(std::memory_order_acquire) == 0 && mVersion.load(std::memory_order_relaxed) == version;
+    }
+
+private:
+    std::atomic<uint32_t> mWriters = 0;
+    std::atomic<uint64_t> mVersion = 0;
+};
+
+} // namespace stfefane::params
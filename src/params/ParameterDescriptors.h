@@ -0,0 +1,99 @@
+#pragma once
+
+#include "ParamValueType.h"
+#include "dsp/MultiDisto.h"
+
+#include <array>
+#include <clap/ext/params.h>
+#include <cstddef>
+#include <string_view>
+
+namespace stfefane::params {
+
+// The ids index the descriptors table, they must stay dense and in the same order.
+enum param_ids : clap_id {
+    eDrive,
+    eDriveType,
+    eInGain,
+    eOutGain,
+    ePreFilterOn,
+    ePreFilterType,
+    ePreFilterFreq,
+    ePreFilterQ,
+    ePreFilterGain,
+    ePostFilterOn,
+    ePostFilterType,
+    ePostFilterFreq,
+    ePostFilterQ,
+    ePostFilterGain,
+    eAsymmetry,
+    eMix,
+    eOversampling,
+    eOversamplingMethod,
+    eAdaaOrder,
+    eFilterTopology,
+};
+
+// A parameter before its creation: its id, name, and the range and display of its value.
+struct ParameterDescriptor {
+    clap_id id = 0;
+    std::string_view name;
+    ParamValueType value_type;
+};
+
+// All the parameters of the plugin, in the order of their ids which is also the order shown by the hosts.
+// The modulatable ones are those continuous values whose modulation the engine smooths per block.
+// Not inline, as the step names are arrays local to each translation unit.
+static constexpr std::array kParameterDescriptors = {
+    ParameterDescriptor{eDrive, "Drive",
+                        ParamValueType::continuous(0., dsp::kMaxDriveDb, 6., " dB", MappingType::Logarithmic).modulatable()},
+    ParameterDescriptor{eDriveType, "Drive Type", ParamValueType::stepped(dsp::kDistortionTypeNames, 0.)},
+    ParameterDescriptor{eInGain, "Input Gain", ParamValueType::continuous(-12., 24., 0., " dB", MappingType::Logarithmic)},
+    ParameterDescriptor{eOutGain, "Output Gain", ParamValueType::continuous(-24., 6., 0., " dB", MappingType::Logarithmic)},
+
+    ParameterDescriptor{ePreFilterOn, "Pre Filter On", ParamValueType::boolean(true)},
+    ParameterDescriptor{ePreFilterType, "Pre Filter Type", ParamValueType::stepped(dsp::kFilterTypeNames, 0.)},
+    ParameterDescriptor{ePreFilterFreq, "Pre Filter Freq",
+                        ParamValueType::continuous(20., 20000., 10000., " Hz", MappingType::Logarithmic)
+                            .withPrefixes()
+                            .modulatable()},
+    ParameterDescriptor{ePreFilterQ, "Pre Filter Q", ParamValueType::continuous(0.1, 35., 0.707, "", MappingType::Logarithmic)},
+    ParameterDescriptor{ePreFilterGain, "Pre Filter Gain", ParamValueType::continuous(-12., 12., 0., " dB")},
+
+    ParameterDescriptor{ePostFilterOn, "Post Filter On", ParamValueType::boolean(true)},
+    ParameterDescriptor{ePostFilterType, "Post Filter Type", ParamValueType::stepped(dsp::kFilterTypeNames, 1.)},
+    ParameterDescriptor{ePostFilterFreq, "Post Filter Freq",
+                        ParamValueType::continuous(20., 20000., 80., " Hz", MappingType::Logarithmic)
+                            .withPrefixes()
+                            .modulatable()},
+    ParameterDescriptor{ePostFilterQ, "Post Filter Q", ParamValueType::continuous(0.1, 35., 0.707, "", MappingType::Logarithmic)},
+    ParameterDescriptor{ePostFilterGain, "Post Filter Gain", ParamValueType::continuous(-12., 12., 0., " dB")},
+
+    ParameterDescriptor{eAsymmetry, "Asymmetry",
+                        ParamValueType::continuous(-0.5, 0.5, 0., "", MappingType::BipolarSCurve).modulatable()},
+    ParameterDescriptor{eMix, "Mix", ParamValueType::continuous(0., 100., 50., " %")},
+
+    // Changing the oversampling restarts the processing, so it can't be automated.
+    ParameterDescriptor{eOversampling, "Oversampling", ParamValueType::stepped(dsp::kOversamplingFactorNames, 2., false)},
+    ParameterDescriptor{eOversamplingMethod, "Oversampling Filter",
+                        ParamValueType::stepped(dsp::kOversamplingMethodNames, 0., false)},
+    ParameterDescriptor{eAdaaOrder, "Antiderivative AA", ParamValueType::stepped(dsp::kAdaaOrderNames, 0., false)},
+    // Switching the topology resets the filters states, it's a setting rather than something to automate.
+    ParameterDescriptor{eFilterTopology, "Filter Topology", ParamValueType::stepped(dsp::kFilterTopologyNames, 0., false)},
+};
+
+static constexpr std::size_t kNbParameters = kParameterDescriptors.size();
+
+static_assert(kNbParameters == eFilterTopology + 1, "every parameter id needs a descriptor");
+static_assert(
+    [] {
+        for (std::size_t i = 0; i < kNbParameters; ++i) {
+            if (kParameterDescriptors[i].id != i) {
+                return false;
+            }
+        }
+        return true;
+    }(),
+    "the descriptors must be in the order of their ids");
+
+} // namespace stfefane::params
@@ -0,0 +1,86 @@
+#include "ParameterSnapshot.h"
+
+#include "utils/Utils.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace stfefane::params {
+
+ParameterSnapshot::ParameterSnapshot(const Parameters& parameters) : mParameters(parameters) {
+    // Nothing is processing yet, the values can be read as they are.
+    const auto version = mParameters.changes().beginRead().value_or(0);
+    read(mValues, version);
+    mValuesVersion = version;
+    convert(mBuffers[mCurrent]);
+}
+
+const dsp::DspParameters& ParameterSnapshot::update() noexcept {
+    bool changed = std::exchange(mModulationChanged, false);
+    if (const auto version = mParameters.changes().beginRead(); version && version != mValuesVersion) {
+        Values values;
+        if (read(values, *version)) {
+            mValues = values;
+            mValuesVersion = version;
+            changed = true;
+        }
+    }
+    if (!changed) {
+        return current();
+    }
+
+    auto& next = mBuffers[1 - mCurrent];
+    convert(next);
+    next.version = ++mSequence;
+    mCurrent = 1 - mCurrent;
+    return current();
+}
+
+void ParameterSnapshot::setModulation(clap_id param_id, double amount) noexcept {
+    if (Parameters::isValidParamId(param_id) && mModulation[param_id] != amount) {
+        mModulation[param_id] = amount;
+        mModulationChanged = true;
+    }
+}
+
+bool ParameterSnapshot::read(Values& values, uint64_t version) const noexcept {
+    for (std::size_t i = 0; i < kNbParameters; ++i) {
+        values[i] = mParameters.getParamByIndex(i)->getValue();
+    }
+    return mParameters.changes().endRead(version);
+}
+
+void ParameterSnapshot::convert(dsp::DspParameters& snapshot) const noexcept {
+    const auto value = [this](clap_id id) { return mValues[id]; };
+    const auto denormalized = [this](clap_id id, double value) {
+        return kParameterDescriptors[id].value_type.denormalizedValue(value);
+    };
+    // Plain values without and with the modulation, which can't go past the range of the parameter.
+    const auto plain = [&](clap_id id) { return denormalized(id, mValues[id]); };
+    const auto modulated = [&](clap_id id) { return denormalized(id, std::clamp(mValues[id] + mModulation[id], 0., 1.)); };
+    const auto filter = [&](clap_id on, clap_id type, clap_id freq, clap_id q, clap_id gain) {
+        return dsp::FilterSettings{
+            .on = value(on) > .5,
+            .type = static_cast<dsp::FilterType>(value(type) + 1), // +1 because we skip None.
+            .freq = plain(freq),
+            .q = plain(q),
+            .gain_db = plain(gain),
+            .freq_modulation = std::log2(modulated(freq) / plain(freq)),
+        };
+    };
+
+    snapshot.type = static_cast<dsp::DistortionType>(value(eDriveType));
+    snapshot.drive = utils::dbToLinear(plain(eDrive));
+    snapshot.drive_modulation = utils::dbToLinear(modulated(eDrive) - plain(eDrive));
+    snapshot.input_gain = utils::dbToLinear(plain(eInGain));
+    snapshot.output_gain = utils::dbToLinear(plain(eOutGain));
+    snapshot.asymmetry = plain(eAsymmetry);
+    snapshot.asymmetry_modulation = modulated(eAsymmetry) - plain(eAsymmetry);
+    snapshot.mix = value(eMix);
+    snapshot.pre_filter = filter(ePreFilterOn, ePreFilterType, ePreFilterFreq, ePreFilterQ, ePreFilterGain);
+    snapshot.post_filter = filter(ePostFilterOn, ePostFilterType, ePostFilterFreq, ePostFilterQ, ePostFilterGain);
+    snapshot.filter_topology = static_cast<dsp::FilterTopology>(value(eFilterTopology));
+}
+
+} // namespace stfefane::params
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "Parameters.h"
+#include "dsp/MultiDisto.h"
+
+#include <array>
+#include <clap/id.h>
+#include <cstdint>
+#include <optional>
+
+namespace stfefane::params {
+
+/**
+ * Parameter values converted for the engine, double buffered so the audio thread adopts them all at once.
+ * The values are written from any thread, the snapshot is only read and updated by the thread that processes.
+ * A new snapshot is built in the back buffer when the values changed, and only swapped in when no write happened
+ * while reading them. Otherwise the current one stays in use, and the next block tries again.
+ * The host modulation is kept apart from the values: it comes with the events of the processing thread, is never
+ * written back to the parameters, and is turned into offsets the engine applies on top of the values.
+ */
+class ParameterSnapshot {
+public:
+    explicit ParameterSnapshot(const Parameters& parameters);
+
+    // Picks the latest values up if possible, and returns the snapshot to process the next block with.
+    const dsp::DspParameters& update() noexcept;
+
+    // Modulation amount of a parameter in its normalized range, picked up by the next update.
+    void setModulation(clap_id param_id, double amount) noexcept;
+
+    [[nodiscard]] const dsp::DspParameters& current() const noexcept { return mBuffers[mCurrent]; }
+
+private:
+    using Values = std::array<double, kNbParameters>;
+
+    // Reads all the values, false when they were written meanwhile.
+    bool read(Values& values, uint64_t version) const noexcept;
+    void convert(dsp::DspParameters& snapshot) const noexcept;
+
+    const Parameters& mParameters;
+    // Last consistent values, and their version
+    Values mValues = {};
+    std::optional<uint64_t> mValuesVersion;
+    Values mModulation = {};
+    bool mModulationChanged = false;
+
+    std::array<dsp::DspParameters, 2> mBuffers;
+    uint32_t mCurrent = 0;
+    // The snapshots are numbered by their own counter, as the modulation changes them without any new value.
+    uint64_t mSequence = 0;
+};
+
+} // namespace stfefane::params
@@ -1,52 +1,43 @@
 #pragma once
 
 #include "Parameter.h"
+#include "ParameterChanges.h"
+#include "ParameterDescriptors.h"
 
+#include <array>
 #include <clap/id.h>
-#include <vector>
-#include <unordered_map>
+#include <span>
+#include <utility>
 
 namespace stfefane::params {
 
-enum param_ids : clap_id {
-    eDrive,
-    eDriveType,
-    eInGain,
-    eOutGain,
-    ePreFilterOn,
-    ePreFilterType,
-    ePreFilterFreq,
-    ePreFilterQ,
-    ePreFilterGain,
-    ePostFilterOn,
-    ePostFilterType,
-    ePostFilterFreq,
-    ePostFilterQ,
-    ePostFilterGain,
-    eAsymmetry,
-    eMix,
-};
-
+// The parameters of kParameterDescriptors, stored contiguously and indexed by their id.
 class Parameters {
 public:
     Parameters();
 
-    void addParameter(clap_id id, const std::string& name, std::unique_ptr<ParamValueType> value_type);
+    [[nodiscard]] static constexpr size_t count() noexcept { return kNbParameters; }
 
-    [[nodiscard]] size_t count() const noexcept { return mParameters.size(); }
+    [[nodiscard]] static constexpr bool isValidParamId(const clap_id param_id) noexcept { return param_id < kNbParameters; }
 
-    [[nodiscard]] bool isValidParamId(const clap_id param_id) const noexcept { return mIdToParameter.contains(param_id); }
-    [[nodiscard]] double getParamValue(const clap_id param_id) const { return mIdToParameter.at(param_id)->getValue(); }
-    [[nodiscard]] const ParamValueType& getParamValueType(const clap_id param_id) const { return mIdToParameter.at(param_id)->getValueType(); }
+    // nullptr for an unknown id or index
+    [[nodiscard]] Parameter* getParamById(clap_id id) const noexcept { return id < kNbParameters ? &mParameters[id] : nullptr; }
+    [[nodiscard]] Parameter* getParamByIndex(size_t index) const noexcept {
+        return index < kNbParameters ? &mParameters[index] : nullptr;
+    }
 
-    [[nodiscard]] Parameter* getParamById(clap_id id) const noexcept;
-    [[nodiscard]] Parameter* getParamByIndex(size_t index) const noexcept;
+    [[nodiscard]] std::span<Parameter> getParams() const { return mParameters; }
 
-    [[nodiscard]] const std::vector<std::unique_ptr<Parameter>>& getParams() const { return mParameters; }
+    // Version of the values, a Scope on it groups several writes into one change.
+    [[nodiscard]] ParameterChanges& changes() const noexcept { return mChanges; }
 
 private:
-    std::vector<std::unique_ptr<Parameter>> mParameters;
-    std::unordered_map<clap_id, Parameter*> mIdToParameter;
+    template <std::size_t... kIds>
+    std::array<Parameter, kNbParameters> makeParameters(std::index_sequence<kIds...>);
+
+    mutable ParameterChanges mChanges;
+    // The values are atomics, written through the parameters handed out by the const accessors.
+    mutable std::array<Parameter, kNbParameters> mParameters;
 };
 
-} // namespace stfefane::params
\ No newline at end of file
+} // namespace stfefane::params
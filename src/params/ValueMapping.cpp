@@ -5,8 +5,6 @@
 
 namespace stfefane::params {
 
-ValueMapping::ValueMapping(MappingType type, double min, double max) : mType(type), mMin(min), mMax(max), mRange(mMax - mMin) {
-}
 double ValueMapping::normalize(double value) const {
     if (mRange <= 0.0) {
         return 0.0;
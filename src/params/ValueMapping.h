@@ -11,7 +11,8 @@ enum class MappingType {
 class ValueMapping {
 public:
     ValueMapping() = default;
-    explicit ValueMapping(MappingType type, double min, double max);
+    constexpr explicit ValueMapping(MappingType type, double min, double max)
+        : mMin(min), mMax(max), mRange(max - min), mType(type) {}
 
     [[nodiscard]] double normalize(double value) const;
     [[nodiscard]] double denormalize(double value) const;
@@ -15,7 +15,7 @@ nlohmann::json PresetManager::getCurrentState() const {
     // Store all parameters in the JSON object
     j["state_version"] = PROJECT_VERSION;
     for (const auto& param: mDisstortion.getParameters().getParams()) {
-        j[param->getInfo().name] = param->getValue();
+        j[param.getInfo().name] = param.getValue();
     }
     return j;
 }
@@ -27,8 +27,13 @@ bool PresetManager::loadStateFromBuffer(const char* buffer) const {
 
         const auto state_version = j["state_version"].get<std::string>();
         if (state_version == PROJECT_VERSION) {
-            for (const auto& param: mDisstortion.getParameters().getParams()) {
-                param->setValue(j[param->getInfo().name].get<double>());
+            // The audio thread picks the whole state up at once, rather than a mix of the old and new values.
+            const params::ParameterChanges::Scope change(mDisstortion.getParameters().changes());
+            for (auto& param: mDisstortion.getParameters().getParams()) {
+                // Parameters missing from older states keep their current value.
+                if (const auto it = j.find(param.getInfo().name); it != j.end()) {
+                    param.setValue(it->get<double>());
+                }
             }
         } else {
             // TODO: handle changes between versions.
@@ -76,8 +81,11 @@ void PresetManager::setCurrentPreset(std::string_view preset_name) {
 }
 
 void PresetManager::resetPresetState() {
-    for (const auto& param: mDisstortion.getParameters().getParams()) {
-        param->reset();
+    {
+        const params::ParameterChanges::Scope change(mDisstortion.getParameters().changes());
+        for (auto& param: mDisstortion.getParameters().getParams()) {
+            param.reset();
+        }
     }
     setCurrentPreset(kInitPreset);
 }
@@ -5,11 +5,13 @@
 #endif
 #include <algorithm>
 #include <cmath>
+#include <cstdio>
+#include <cstdlib>
 #include <numbers>
 #include <optional>
 #include <sstream>
-#include <stdexcept>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include <clap/stream.h>
@@ -27,24 +29,51 @@ template<typename FLOATING_TYPE>
     return std::fabs(a - b) < kEpsilon;
 }
 
-[[nodiscard]] inline double stringToDouble(const std::string& str) {
+// Parses the number at the start of str, nullopt when there's none.
+// Sets used to the number of characters parsed, the rest of str being left to the caller.
+[[nodiscard]] inline std::optional<double> stringToDouble(std::string_view str, size_t* used = nullptr) noexcept {
 #ifdef __APPLE__
+    // No floating point from_chars on older macOS, strtod needs a null terminated copy.
+    char copy[64];
+    const auto size = std::min(str.size(), sizeof(copy) - 1);
+    std::copy_n(str.data(), size, copy);
+    copy[size] = '\0';
     char* end;
-    double result = std::strtod(str.c_str(), &end);
-    if (end == str.c_str()) {
-        throw std::invalid_argument("Invalid number format");
+    const double result = std::strtod(copy, &end);
+    if (end == copy) {
+        return std::nullopt;
+    }
+    if (used) {
+        *used = static_cast<size_t>(end - copy);
     }
     return result;
 #else
+    // from_chars doesn't skip a leading plus sign like strtod does.
+    const size_t sign = !str.empty() && str.front() == '+' ? 1 : 0;
     double result = 0.0;
-    auto [ptr, ec] = std::from_chars(str.c_str(), str.c_str() + str.size(), result);
+    auto [ptr, ec] = std::from_chars(str.data() + sign, str.data() + str.size(), result);
     if (ec != std::errc{}) {
-        throw std::invalid_argument("Invalid number format");
+        return std::nullopt;
+    }
+    if (used) {
+        *used = static_cast<size_t>(ptr - str.data());
     }
     return result;
 #endif
 }
 
+// Writes value with a fixed number of decimals in [first, last), returns the end of the text or nullptr if it doesn't fit.
+[[nodiscard]] inline char* doubleToString(char* first, char* last, double value, int precision) noexcept {
+#ifdef __APPLE__
+    const auto size = static_cast<size_t>(last - first);
+    const int written = std::snprintf(first, size, "%.*f", precision, value);
+    return written >= 0 && static_cast<size_t>(written) < size ? first + written : nullptr;
+#else
+    auto [ptr, ec] = std::to_chars(first, last, value, std::chars_format::fixed, precision);
+    return ec == std::errc{} ? ptr : nullptr;
+#endif
+}
+
 [[nodiscard]] inline double dbToLinear(double dB) {
     return std::pow(10.0, dB / 20.0);
 }